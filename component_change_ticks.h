@@ -0,0 +1,134 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <span>
+#include <unordered_map>
+#include <vector>
+
+#include "entity.h"
+
+namespace RaccoonEcs
+{
+	using ChangeTick = std::uint64_t;
+
+	/**
+	 * @brief Stores the tick of the last write for each component of tracked types
+	 *
+	 * Tick 0 means that the component wasn't changed since tracking was enabled
+	 */
+	template<typename ComponentTypeId>
+	class ComponentChangeTicksImpl
+	{
+	public:
+		using TicksVector = std::vector<ChangeTick>;
+
+	public:
+		void setTracking(ComponentTypeId typeId, const bool isTracked)
+		{
+			if (isTracked)
+			{
+				mTicks.try_emplace(typeId);
+			}
+			else
+			{
+				mTicks.erase(typeId);
+			}
+		}
+
+		[[nodiscard]] bool isAnyTracked() const noexcept
+		{
+			return !mTicks.empty();
+		}
+
+		/**
+		 * @return ticks of the given type, or nullptr if the type is not tracked
+		 */
+		[[nodiscard]] TicksVector* getTicks(ComponentTypeId typeId)
+		{
+			if (mTicks.empty())
+			{
+				return nullptr;
+			}
+			auto it = mTicks.find(typeId);
+			return it == mTicks.end() ? nullptr : &it->second;
+		}
+
+		[[nodiscard]] const TicksVector* getTicks(ComponentTypeId typeId) const
+		{
+			return const_cast<ComponentChangeTicksImpl*>(this)->getTicks(typeId);
+		}
+
+		void markChanged(ComponentTypeId typeId, const size_t entityIdx)
+		{
+			if (TicksVector* ticks = getTicks(typeId))
+			{
+				markChanged(*ticks, entityIdx);
+			}
+		}
+
+		void markChanged(TicksVector& ticks, const size_t entityIdx) const
+		{
+			if (ticks.size() <= entityIdx)
+			{
+				if (ticks.capacity() <= entityIdx)
+				{
+					ticks.reserve((entityIdx + 1) * 2);
+				}
+				ticks.resize(entityIdx + 1, 0);
+			}
+			ticks[entityIdx] = mCurrentTick;
+		}
+
+		[[nodiscard]] static ChangeTick getTick(const TicksVector& ticks, const size_t entityIdx) noexcept
+		{
+			return entityIdx < ticks.size() ? ticks[entityIdx] : 0;
+		}
+
+		[[nodiscard]] ChangeTick getCurrentTick() const noexcept { return mCurrentTick; }
+
+		/**
+		 * @brief Starts a new tick, changes made after this call will be newer than the returned value
+		 * @return the tick that was current before the call
+		 */
+		ChangeTick advanceTick() noexcept
+		{
+			return mCurrentTick++;
+		}
+
+		/**
+		 * @brief Moves the ticks to new entity indexes, see EntityManagerImpl::compactEntityIds
+		 * @param oldIdxByNewIdx  Old index for every new index, ascending, indexes that get no entity have an out of range value
+		 */
+		void compactEntities(std::span<const Entity::RawId> oldIdxByNewIdx)
+		{
+			for (auto& [typeId, ticks] : mTicks)
+			{
+				// have to use this weird syntax because it otherwise can break on MSVC is someone
+				// inludes <windows.h> before this file without NOMINMAX defined
+				const size_t ticksCount = (std::min)(ticks.size(), oldIdxByNewIdx.size());
+				for (size_t newIdx = 0; newIdx < ticksCount; ++newIdx)
+				{
+					ticks[newIdx] = getTick(ticks, oldIdxByNewIdx[newIdx]);
+				}
+				ticks.resize(ticksCount);
+				ticks.shrink_to_fit();
+			}
+		}
+
+		/**
+		 * @brief Forgets recorded ticks but keeps tracked types and the current tick
+		 */
+		void clearTicks()
+		{
+			for (auto& [typeId, ticks] : mTicks)
+			{
+				ticks.clear();
+			}
+		}
+
+	private:
+		std::unordered_map<ComponentTypeId, TicksVector> mTicks;
+		ChangeTick mCurrentTick = 1;
+	};
+} // namespace RaccoonEcs
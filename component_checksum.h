@@ -0,0 +1,151 @@
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <unordered_map>
+#include <vector>
+
+#include "component_change_ticks.h"
+#include "entity.h"
+
+namespace RaccoonEcs
+{
+	/**
+	 * @brief Finalizer of splitmix64, spreads every input bit over the whole result
+	 */
+	[[nodiscard]] constexpr std::uint64_t mixHash(std::uint64_t value) noexcept
+	{
+		value ^= value >> 30;
+		value *= 0xBF58476D1CE4E5B9ull;
+		value ^= value >> 27;
+		value *= 0x94D049BB133111EBull;
+		value ^= value >> 31;
+		return value;
+	}
+
+	/**
+	 * @brief Fast non-cryptographic hash of memory, processes eight bytes per step
+	 *
+	 * Gives the same results on all platforms with the same endianness
+	 */
+	[[nodiscard]] inline std::uint64_t hashBytes(const void* data, const size_t size) noexcept
+	{
+		const unsigned char* bytes = static_cast<const unsigned char*>(data);
+		std::uint64_t hash = mixHash(static_cast<std::uint64_t>(size));
+
+		size_t offset = 0;
+		for (; offset + sizeof(std::uint64_t) <= size; offset += sizeof(std::uint64_t))
+		{
+			std::uint64_t word;
+			std::memcpy(&word, bytes + offset, sizeof(word));
+			hash = mixHash(hash ^ word);
+		}
+
+		if (offset < size)
+		{
+			std::uint64_t word = 0;
+			std::memcpy(&word, bytes + offset, size - offset);
+			hash = mixHash(hash ^ word);
+		}
+		return hash;
+	}
+
+	/**
+	 * @brief State of the checksum entries remembered between checksum calculations,
+	 * see EntityManagerImpl::computeChecksum
+	 *
+	 * Should be used only with one entity manager
+	 */
+	template<typename ComponentTypeId>
+	class ComponentChecksumCacheImpl
+	{
+	public:
+		/**
+		 * @brief Versions of the alive entities that were hashed, entity entries depend only on them
+		 */
+		struct EntityEntries
+		{
+			std::vector<Entity::Version> versions;
+			std::vector<bool> isAlive;
+			std::uint64_t hashSum = 0;
+			std::uint64_t entriesCount = 0;
+		};
+
+		/**
+		 * @brief Hashes of the entries of components of one type by entity index together with their running sum,
+		 * so only the entries that changed need to be rehashed
+		 */
+		struct ComponentEntries
+		{
+			struct Entry
+			{
+				std::uint64_t hash = 0;
+				// the state that was hashed, the component is nullptr if there is no entry
+				const void* component = nullptr;
+				bool wasDisabled = false;
+			};
+
+			std::vector<Entry> entries;
+			// salt of the enabled entries, depends on the position of the type in the list of types
+			std::uint64_t salt = 0;
+			std::uint64_t hashSum = 0;
+			std::uint64_t entriesCount = 0;
+
+			[[nodiscard]] size_t size() const noexcept { return entries.size(); }
+
+			void resize(const size_t newSize)
+			{
+				entries.resize(newSize);
+			}
+
+			void setEntry(const size_t entityIdx, const std::uint64_t entryHash, const void* component, const bool isDisabled)
+			{
+				removeEntry(entityIdx);
+				entries[entityIdx] = { entryHash, component, isDisabled };
+				hashSum += entryHash;
+				++entriesCount;
+			}
+
+			void removeEntry(const size_t entityIdx)
+			{
+				Entry& entry = entries[entityIdx];
+				if (entry.component != nullptr)
+				{
+					hashSum -= entry.hash;
+					--entriesCount;
+					entry = {};
+				}
+			}
+		};
+
+	public:
+		[[nodiscard]] EntityEntries& getEntityEntries() noexcept
+		{
+			return mEntityEntries;
+		}
+
+		[[nodiscard]] ComponentEntries& getComponentEntries(ComponentTypeId typeId)
+		{
+			return mComponentEntries[typeId];
+		}
+
+		[[nodiscard]] ChangeTick getLastTick() const noexcept { return mLastTick; }
+		void setLastTick(const ChangeTick tick) noexcept { mLastTick = tick; }
+
+		/**
+		 * @brief Forgets all the hashes, needed after the components are replaced without
+		 * being marked as changed, e.g. when the manager was overridden or loaded from a snapshot
+		 */
+		void clear()
+		{
+			mEntityEntries = {};
+			mComponentEntries.clear();
+			mLastTick = 0;
+		}
+
+	private:
+		EntityEntries mEntityEntries;
+		std::unordered_map<ComponentTypeId, ComponentEntries> mComponentEntries;
+		ChangeTick mLastTick = 0;
+	};
+} // namespace RaccoonEcs
@@ -0,0 +1,126 @@
+#pragma once
+
+#include <span>
+#include <unordered_map>
+#include <vector>
+
+#include "entity.h"
+
+namespace RaccoonEcs
+{
+	enum class ComponentEventType
+	{
+		Added,
+		Removed
+	};
+
+	template<typename ComponentTypeId>
+	struct ComponentEventImpl
+	{
+		ComponentEventImpl(const Entity entity, ComponentTypeId typeId, const ComponentEventType type)
+			: entity(entity)
+			, typeId(typeId)
+			, type(type)
+		{}
+
+		Entity entity;
+		ComponentTypeId typeId;
+		ComponentEventType type;
+	};
+
+	/**
+	 * @brief Batched buffers of component additions and removals, one buffer per tracked component type
+	 *
+	 * Events are recorded only for types that have tracking enabled, and stay in the buffer until consumed,
+	 * so a system can process only the entities that changed since its last update
+	 */
+	template<typename ComponentTypeId>
+	class ComponentEventsImpl
+	{
+	public:
+		using ComponentEvent = ComponentEventImpl<ComponentTypeId>;
+
+	public:
+		void setTracking(ComponentTypeId typeId, const bool isTracked)
+		{
+			if (isTracked)
+			{
+				mStreams.try_emplace(typeId);
+			}
+			else
+			{
+				mStreams.erase(typeId);
+			}
+		}
+
+		[[nodiscard]] bool isTracked(ComponentTypeId typeId) const
+		{
+			return !mStreams.empty() && mStreams.contains(typeId);
+		}
+
+		[[nodiscard]] bool isAnyTracked() const noexcept
+		{
+			return !mStreams.empty();
+		}
+
+		void record(const Entity entity, ComponentTypeId typeId, const ComponentEventType type)
+		{
+			if (mStreams.empty())
+			{
+				return;
+			}
+
+			if (auto it = mStreams.find(typeId); it != mStreams.end())
+			{
+				it->second.emplace_back(entity, typeId, type);
+			}
+		}
+
+		/**
+		 * @return events of the given type in the order they happened, empty if the type is not tracked
+		 */
+		[[nodiscard]] std::span<const ComponentEvent> getEvents(ComponentTypeId typeId) const
+		{
+			if (auto it = mStreams.find(typeId); it != mStreams.end())
+			{
+				return it->second;
+			}
+			return {};
+		}
+
+		void clearEvents(ComponentTypeId typeId)
+		{
+			if (auto it = mStreams.find(typeId); it != mStreams.end())
+			{
+				it->second.clear();
+			}
+		}
+
+		void clearAllEvents()
+		{
+			for (auto& [typeId, events] : mStreams)
+			{
+				events.clear();
+			}
+		}
+
+		/**
+		 * @brief Replaces entities of the recorded events, e.g. when entities get new ids
+		 * @param remapFn  Returns the new handle of the given entity, or the same entity if it is not changed
+		 */
+		template<typename RemapFn>
+		void remapEntities(RemapFn&& remapFn)
+		{
+			for (auto& [typeId, events] : mStreams)
+			{
+				for (ComponentEvent& event : events)
+				{
+					event.entity = remapFn(event.entity);
+				}
+			}
+		}
+
+	private:
+		std::unordered_map<ComponentTypeId, std::vector<ComponentEvent>> mStreams;
+	};
+} // namespace RaccoonEcs
@@ -1,11 +1,16 @@
 #pragma once
 
 #include <algorithm>
+#include <cstdint>
 #include <functional>
 #include <memory>
 #include <string>
+#include <type_traits>
 #include <unordered_map>
+#include <unordered_set>
+#include <vector>
 
+#include "component_checksum.h"
 #include "component_pool.h"
 #include "error_handling.h"
 
@@ -26,6 +31,8 @@ namespace RaccoonEcs
 		using CreationFn = std::function<void*()>;
 		using DeletionFn = std::function<void(void*)>;
 		using CloneFn = std::function<void*(void*)>;
+		using CloneComponentsFn = std::function<void(const std::vector<void*>&, std::vector<void*>&)>;
+		using HashFn = std::function<std::uint64_t(const void*)>;
 
 		ComponentFactoryImpl() = default;
 		ComponentFactoryImpl(ComponentFactoryImpl&) = delete;
@@ -43,6 +50,7 @@ namespace RaccoonEcs
 		{
 			const ComponentTypeId componentTypeId = ComponentType::GetTypeId();
 
+			mTagComponentTypes.insert(componentTypeId);
 			mComponentCreators[componentTypeId] = [] {
 				// the component has no data, so we don't need to allocate it
 				static ComponentType component;
@@ -54,6 +62,9 @@ namespace RaccoonEcs
 				// all instances are mapping to the same memory, so we can just return the pointer
 				return component;
 			};
+			mComponentVectorCloners[componentTypeId] = [](const std::vector<void*>& source, std::vector<void*>& destination) {
+				destination = source;
+			};
 #endif // RACCOON_ECS_COPYABLE_COMPONENTS
 		}
 
@@ -69,6 +80,7 @@ namespace RaccoonEcs
 
 			auto componentPoolRawPtr = new (std::nothrow) ComponentPool<ComponentType>(defaultChunkSize, needPreallocate, std::move(poolGrowStrategyFn));
 			mComponentPools.emplace_back(componentPoolRawPtr);
+			mComponentPoolsById[componentTypeId] = componentPoolRawPtr;
 
 			mComponentCreators[componentTypeId] = [componentPoolRawPtr] {
 				return componentPoolRawPtr->acquireComponent();
@@ -90,7 +102,48 @@ namespace RaccoonEcs
 					return nullptr;
 				}
 			};
+			mComponentVectorCloners[componentTypeId] = [componentPoolRawPtr](const std::vector<void*>& source, std::vector<void*>& destination) {
+				componentPoolRawPtr->cloneComponents(source, destination);
+			};
 #endif // RACCOON_ECS_COPYABLE_COMPONENTS
+			if constexpr (std::is_trivially_copyable_v<ComponentType>)
+			{
+				mTriviallyCopyableComponentSizes[componentTypeId] = sizeof(ComponentType);
+			}
+			// bytes of padding are unspecified after assignments, so only types without padding are hashed bytewise by default
+			if constexpr (std::has_unique_object_representations_v<ComponentType>)
+			{
+				setBytewiseComponentHashFn<ComponentType>();
+			}
+		}
+
+		/**
+		 * @brief Sets the function that hashes the content of components of the given type for checksums
+		 *
+		 * Only components with std::has_unique_object_representations (integers and enums without padding)
+		 * are hashed bytewise by default. Other types, including any struct with float or double fields,
+		 * need a hash function (or setBytewiseComponentHashFn), otherwise computeChecksum refuses them
+		 */
+		template<typename ComponentType>
+		void setComponentHashFn(HashFn&& hashFn)
+		{
+			mComponentHashers[ComponentType::GetTypeId()] = std::move(hashFn);
+		}
+
+		/**
+		 * @brief Makes components of the given type hashed bytewise for checksums
+		 *
+		 * For trivially copyable types that don't get the bytewise hash by default, e.g. structs of floats.
+		 * Padding bytes are hashed too, so they should be zeroed, otherwise the hashes can differ for equal components.
+		 * Note that 0.0 and -0.0 get different hashes, as do NaNs with different bits
+		 */
+		template<typename ComponentType>
+		void setBytewiseComponentHashFn()
+		{
+			static_assert(std::is_trivially_copyable_v<ComponentType>, "Only trivially copyable components can be hashed bytewise");
+			mComponentHashers[ComponentType::GetTypeId()] = [](const void* component) {
+				return hashBytes(component, sizeof(ComponentType));
+			};
 		}
 
 		[[nodiscard]] CreationFn getCreationFn(ComponentTypeId typeId) const
@@ -129,8 +182,72 @@ namespace RaccoonEcs
 			RACCOON_ECS_ERROR(std::string("Unknown component type: '") + toString(typeId) + "'");
 			return nullptr;
 		}
+
+		/**
+		 * @return function that clones a whole vector of components of the given type with one call,
+		 * keeping nullptr elements in place
+		 */
+		[[nodiscard]] CloneComponentsFn getCloneComponentsFn(ComponentTypeId typeId) const
+		{
+			const auto& it = mComponentVectorCloners.find(typeId);
+			if (it != mComponentVectorCloners.cend())
+			{
+				return it->second;
+			}
+
+			RACCOON_ECS_ERROR(std::string("Unknown component type: '") + toString(typeId) + "'");
+			return nullptr;
+		}
 #endif // RACCOON_ECS_COPYABLE_COMPONENTS
 
+		/**
+		 * @return pool of the given component type, nullptr for tag components
+		 */
+		[[nodiscard]] ComponentPoolBase* getComponentPool(ComponentTypeId typeId) const
+		{
+			const auto& it = mComponentPoolsById.find(typeId);
+			return it != mComponentPoolsById.cend() ? it->second : nullptr;
+		}
+
+		template<typename ComponentType>
+		[[nodiscard]] ComponentPool<ComponentType>* getComponentPool() const
+		{
+			return static_cast<ComponentPool<ComponentType>*>(getComponentPool(ComponentType::GetTypeId()));
+		}
+
+		/**
+		 * @brief Releases the memory chunks of all the component pools that have no acquired components
+		 * @return amount of released component slots
+		 */
+		size_t trimComponentPools() const
+		{
+			size_t releasedSlotsCount = 0;
+			for (const auto& componentPool : mComponentPools)
+			{
+				releasedSlotsCount += componentPool->trim();
+			}
+			return releasedSlotsCount;
+		}
+
+		/**
+		 * @return function that hashes the content of components of the given type, or nullptr if there is none
+		 */
+		[[nodiscard]] HashFn getHashFn(ComponentTypeId typeId) const
+		{
+			const auto& it = mComponentHashers.find(typeId);
+			return it != mComponentHashers.cend() ? it->second : nullptr;
+		}
+
+		/**
+		 * @return size of components of the given type if they are trivially copyable, so their bytes can be
+		 * copied and compared directly, otherwise 0
+		 */
+		[[nodiscard]] size_t getTriviallyCopyableComponentSize(ComponentTypeId typeId) const
+		{
+			const auto& it = mTriviallyCopyableComponentSizes.find(typeId);
+			return it != mTriviallyCopyableComponentSizes.cend() ? it->second : 0;
+		}
+
 		[[nodiscard]] void* createComponent(ComponentTypeId typeId) const
 		{
 			const auto& it = mComponentCreators.find(typeId);
@@ -142,6 +259,15 @@ namespace RaccoonEcs
 			return nullptr;
 		}
 
+		/**
+		 * @return true if the type was registered as a component without data (a tag),
+		 * such components are stored in entity managers as bits instead of pointers
+		 */
+		[[nodiscard]] bool isTagComponent(ComponentTypeId typeId) const
+		{
+			return mTagComponentTypes.contains(typeId);
+		}
+
 		template<typename F>
 		void forEachComponentType(F fn) const
 		{
@@ -153,11 +279,16 @@ namespace RaccoonEcs
 
 	private:
 		std::vector<std::unique_ptr<ComponentPoolBase>> mComponentPools;
+		std::unordered_map<ComponentTypeId, ComponentPoolBase*> mComponentPoolsById;
 
 		std::unordered_map<ComponentTypeId, CreationFn> mComponentCreators;
 		std::unordered_map<ComponentTypeId, DeletionFn> mComponentDeleters;
+		std::unordered_set<ComponentTypeId> mTagComponentTypes;
+		std::unordered_map<ComponentTypeId, HashFn> mComponentHashers;
+		std::unordered_map<ComponentTypeId, size_t> mTriviallyCopyableComponentSizes;
 #ifdef RACCOON_ECS_COPYABLE_COMPONENTS
 		std::unordered_map<ComponentTypeId, CloneFn> mComponentCloners;
+		std::unordered_map<ComponentTypeId, CloneComponentsFn> mComponentVectorCloners;
 #endif // RACCOON_ECS_COPYABLE_COMPONENTS
 	};
 
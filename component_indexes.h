@@ -3,13 +3,19 @@
 #include <algorithm>
 #include <array>
 #include <bit>
+#include <cstdint>
 #include <limits>
 #include <memory>
+#include <numeric>
+#include <span>
 #include <tuple>
 #include <unordered_map>
+#include <utility>
 #include <vector>
 
 #include "component_map.h"
+#include "entity.h"
+#include "entity_slots.h"
 
 namespace RaccoonEcs
 {
@@ -57,13 +63,13 @@ namespace RaccoonEcs
 		ComponentIndexes& operator=(ComponentIndexes&& other) noexcept = default;
 		~ComponentIndexes() = default;
 
-		void onComponentAdded(ComponentTypeId typeId, size_t entityIndex, const ComponentMap& componentMap)
+		void onComponentAdded(ComponentTypeId typeId, const Entity entity, const ComponentMap& componentMap)
 		{
 			if (auto it = mIndexesHavingComponent.find(typeId); it != mIndexesHavingComponent.end())
 			{
 				for (BaseIndex* index : it->second)
 				{
-					index->tryAddEntity(entityIndex, componentMap);
+					index->tryAddEntity(entity, componentMap);
 				}
 			}
 		}
@@ -87,30 +93,83 @@ namespace RaccoonEcs
 			}
 		}
 
+		/**
+		 * @brief Updates cached pointers when a component of the entity was moved to another address
+		 */
+		void onComponentRelocated(ComponentTypeId typeId, size_t entityIndex, void* newComponent)
+		{
+			if (auto it = mIndexesHavingComponent.find(typeId); it != mIndexesHavingComponent.end())
+			{
+				for (BaseIndex* index : it->second)
+				{
+					index->updateComponentPointer(typeId, entityIndex, newComponent);
+				}
+			}
+		}
+
+		/**
+		 * @brief Adds entities whose components are all already in the component map
+		 */
+		void onEntitiesAdded(std::span<const Entity> entities, const ComponentMap& componentMap)
+		{
+			for (auto& [key, index] : mIndexes)
+			{
+				index->tryAddEntities(entities, componentMap);
+			}
+		}
+
+		void onEntitiesRemoved(std::span<const Entity> entities)
+		{
+			for (auto& [key, index] : mIndexes)
+			{
+				for (const Entity entity : entities)
+				{
+					index->tryRemoveEntity(static_cast<size_t>(entity.getRawId()));
+				}
+			}
+		}
+
+		void onComponentEnabledChanged(ComponentTypeId typeId, size_t entityIndex, const bool isEnabled)
+		{
+			if (auto it = mIndexesHavingComponent.find(typeId); it != mIndexesHavingComponent.end())
+			{
+				for (BaseIndex* index : it->second)
+				{
+					index->setComponentEnabled(typeId, entityIndex, isEnabled);
+				}
+			}
+		}
+
 		template<typename... Components>
-		void initializeIndex(const ComponentMap& componentMap)
+		void initializeIndex(const ComponentMap& componentMap, const EntitySlots& entitySlots)
 		{
-			getOrCreateIndex<std::remove_const_t<Components>...>(componentMap);
+			getOrCreateIndex<std::remove_const_t<Components>...>(componentMap, entitySlots);
 		}
 
+		/**
+		 * @return entities that have all the given components enabled
+		 */
 		template<typename... Components>
-		const std::vector<size_t>& getIndex(const ComponentMap& componentMap)
+		std::span<const Entity> getIndex(const ComponentMap& componentMap, const EntitySlots& entitySlots)
 		{
-			const auto& index = getOrCreateIndex<std::remove_const_t<Components>...>(componentMap);
+			const auto& index = getOrCreateIndex<std::remove_const_t<Components>...>(componentMap, entitySlots);
 			return index.getMatchingEntities();
 		}
 
 		template<typename... Components>
-		size_t getIndexSize(const ComponentMap& componentMap)
+		size_t getIndexSize(const ComponentMap& componentMap, const EntitySlots& entitySlots)
 		{
-			const auto& index = getOrCreateIndex<std::remove_const_t<Components>...>(componentMap);
-			return index.getMatchingEntities().size();
+			const auto& index = getOrCreateIndex<std::remove_const_t<Components>...>(componentMap, entitySlots);
+			return index.getMatchingEntitiesCount();
 		}
 
+		/**
+		 * @return component sets of entities that have all the given components enabled
+		 */
 		template<typename... Components>
-		const std::vector<std::tuple<std::remove_const_t<Components>*...>>& getComponents(const ComponentMap& componentMap)
+		std::span<const std::tuple<std::remove_const_t<Components>*...>> getComponents(const ComponentMap& componentMap, const EntitySlots& entitySlots)
 		{
-			const auto& index = getOrCreateIndex<std::remove_const_t<Components>...>(componentMap);
+			const auto& index = getOrCreateIndex<std::remove_const_t<Components>...>(componentMap, entitySlots);
 			return index.getComponents();
 		}
 
@@ -124,20 +183,83 @@ namespace RaccoonEcs
 			mIndexesHavingComponent.clear();
 		}
 
-		void rebuild(const ComponentMap& componentMap)
+		/**
+		 * @brief Replaces the indexes with copies of the indexes of other
+		 * @param componentMap  The copy of the components of other, the cached pointers will point to it
+		 * @param isTypeCopied  Predicate telling which component types are present in the copy,
+		 * indexes having other types are skipped and will be populated on the first request
+		 *
+		 * Doesn't scan the entities, only the entries that are already in the indexes are copied
+		 */
+		template<typename ComponentTypeFilter>
+		void copyFrom(const ComponentIndexes& other, const ComponentMap& componentMap, const ComponentTypeFilter& isTypeCopied)
+		{
+			clear();
+			for (const auto& [key, index] : other.mIndexes)
+			{
+				if (!std::all_of(key.componentTypes.begin(), key.componentTypes.end(), isTypeCopied))
+				{
+					continue;
+				}
+
+				std::unique_ptr<BaseIndex> indexCopy = index->clone(componentMap);
+				for (ComponentTypeId typeId : key.componentTypes)
+				{
+					mIndexesHavingComponent[typeId].push_back(indexCopy.get());
+				}
+				mIndexes.emplace(key, std::move(indexCopy));
+			}
+		}
+
+		/**
+		 * @brief Updates the entities of the entries when they get new indexes, keeps the order of the entries
+		 * @param newIdxByOldIdx  New index for the old index of every entity that is in the indexes
+		 * @param entitySlots  Entity slots with the new versions
+		 */
+		void remapEntities(std::span<const Entity::RawId> newIdxByOldIdx, const EntitySlots& entitySlots)
 		{
 			for (auto& [key, index] : mIndexes)
 			{
-				index->repopulate(componentMap);
+				index->remapEntities(newIdxByOldIdx, entitySlots);
+			}
+		}
+
+		/**
+		 * @brief Orders the entries of each index by entity indexes, so after the components are placed
+		 * in the order of entities the indexes are iterated in the order of component addresses
+		 */
+		void sortEntriesByEntities()
+		{
+			for (auto& [key, index] : mIndexes)
+			{
+				index->sortEntriesByEntities();
+			}
+		}
+
+		void rebuild(const ComponentMap& componentMap, const EntitySlots& entitySlots)
+		{
+			for (auto& [key, index] : mIndexes)
+			{
+				index->repopulate(componentMap, entitySlots);
 			}
 		}
 
 	private:
+		// bit N is set when N-th component of the set is disabled for the entity
+		using DisabledMask = std::uint32_t;
+
+		/**
+		 * Entries with all components enabled are kept at the beginning of the arrays,
+		 * entries with at least one disabled component are kept after them
+		 */
 		template<typename... Components>
 		struct DenseArray
 		{
 			std::vector<std::tuple<Components*...>> cachedComponents;
-			std::vector<size_t> matchingEntityIndexes;
+			// entities are stored together with their versions, so iterating doesn't need to look them up
+			std::vector<Entity> matchingEntities;
+			std::vector<DisabledMask> disabledMasks;
+			size_t enabledCount = 0;
 
 			DenseArray() = default;
 			~DenseArray() = default;
@@ -157,11 +279,17 @@ namespace RaccoonEcs
 			BaseIndex(BaseIndex&&) noexcept = default;
 			BaseIndex& operator=(BaseIndex&&) noexcept = default;
 
-			virtual void tryAddEntity(size_t entityIndex, const ComponentMap& componentMap) = 0;
+			virtual void tryAddEntity(Entity entity, const ComponentMap& componentMap) = 0;
+			virtual void tryAddEntities(std::span<const Entity> entities, const ComponentMap& componentMap) = 0;
 			virtual void tryRemoveEntity(size_t entityIndex) = 0;
-			virtual void populate(const ComponentMap& componentMap) = 0;
-			virtual void repopulate(const ComponentMap& componentMap) = 0;
+			virtual void setComponentEnabled(ComponentTypeId typeId, size_t entityIndex, bool isEnabled) = 0;
+			virtual void updateComponentPointer(ComponentTypeId typeId, size_t entityIndex, void* newComponent) = 0;
+			virtual void remapEntities(std::span<const Entity::RawId> newIdxByOldIdx, const EntitySlots& entitySlots) = 0;
+			virtual void sortEntriesByEntities() = 0;
+			virtual void populate(const ComponentMap& componentMap, const EntitySlots& entitySlots) = 0;
+			virtual void repopulate(const ComponentMap& componentMap, const EntitySlots& entitySlots) = 0;
 			virtual void clear() = 0;
+			[[nodiscard]] virtual std::unique_ptr<BaseIndex> clone(const ComponentMap& componentMap) const = 0;
 			[[nodiscard]] bool isPopulated() const { return mIsPopulated; }
 
 		protected:
@@ -177,23 +305,20 @@ namespace RaccoonEcs
 		template<typename... Components>
 		class Index final : public BaseIndex
 		{
+			static_assert(sizeof...(Components) <= sizeof(DisabledMask) * 8, "Too many components in one index");
+
 		public:
 			explicit Index()
 				: mComponentTypes({ Components::GetTypeId()... })
 			{}
 
-			void tryAddEntity(size_t entityIndex, const ComponentMap& componentMap) override
+			void tryAddEntity(const Entity entity, const ComponentMap& componentMap) override
 			{
-				using namespace TemplateTrick;
-				std::array<const std::vector<void*>*, sizeof...(Components)> componentVectors;
-				for (size_t i = 0; i < sizeof...(Components); ++i)
+				const size_t entityIndex = static_cast<size_t>(entity.getRawId());
+				const std::tuple<Components*...> components(componentMap.template getColumn<Components>().get(entityIndex)...);
+				if (hasMissingComponents(components))
 				{
-					const std::vector<void*>& componentVector = componentMap.getComponentVectorById(mComponentTypes[i]);
-					if (entityIndex >= componentVector.size() || componentVector[entityIndex] == nullptr)
-					{
-						return;
-					}
-					componentVectors[i] = &componentVector;
+					return;
 				}
 
 				if (mSparseArray.size() <= entityIndex)
@@ -208,44 +333,154 @@ namespace RaccoonEcs
 					mSparseArray.resize(entityIndex + 1, BaseIndex::InvalidIndex);
 				}
 
-				mSparseArray[entityIndex] = mDenseArray.matchingEntityIndexes.size();
-				mDenseArray.cachedComponents.emplace_back(static_cast<Components*>((*componentVectors[Idx<Components, Components...>()])[entityIndex])...);
-				mDenseArray.matchingEntityIndexes.push_back(entityIndex);
+				appendEntry(entity, components, calculateDisabledMask(componentMap, entityIndex));
+			}
+
+			void tryAddEntities(std::span<const Entity> entities, const ComponentMap& componentMap) override
+			{
+				if (entities.empty())
+				{
+					return;
+				}
+
+				const auto columns = std::make_tuple(componentMap.template getColumn<Components>()...);
+
+				const auto maxEntityIt = std::ranges::max_element(entities, {}, [](const Entity entity) { return entity.getRawId(); });
+				const size_t maxEntityIndex = static_cast<size_t>(maxEntityIt->getRawId());
+				if (mSparseArray.size() <= maxEntityIndex)
+				{
+					mSparseArray.resize(maxEntityIndex + 1, BaseIndex::InvalidIndex);
+				}
+
+				const size_t maxEntriesCount = mDenseArray.matchingEntities.size() + entities.size();
+				if (mDenseArray.matchingEntities.capacity() < maxEntriesCount)
+				{
+					// grow geometrically, so transferring many small batches doesn't reallocate on each of them
+					// have to use this weird syntax because it otherwise can break on MSVC is someone
+					// inludes <windows.h> before this file without NOMINMAX defined
+					const size_t newCapacity = (std::max)(maxEntriesCount, mDenseArray.matchingEntities.capacity() * 2);
+					mDenseArray.cachedComponents.reserve(newCapacity);
+					mDenseArray.matchingEntities.reserve(newCapacity);
+					mDenseArray.disabledMasks.reserve(newCapacity);
+				}
+
+				for (const Entity entity : entities)
+				{
+					const size_t entityIndex = static_cast<size_t>(entity.getRawId());
+					const std::tuple<Components*...> components = std::apply(
+						[entityIndex](const auto&... column) {
+							return std::tuple<Components*...>(column.get(entityIndex)...);
+						},
+						columns
+					);
+
+					if (!hasMissingComponents(components))
+					{
+						appendEntry(entity, components, calculateDisabledMask(componentMap, entityIndex));
+					}
+				}
 			}
 
 			void tryRemoveEntity(const size_t entityIndex) override
 			{
 				if (entityIndex < mSparseArray.size())
 				{
-					const size_t idx = mSparseArray[entityIndex];
+					size_t idx = mSparseArray[entityIndex];
 					if (idx != BaseIndex::InvalidIndex)
 					{
-						if (idx != mDenseArray.matchingEntityIndexes.size() - 1)
+						if (idx < mDenseArray.enabledCount)
 						{
-							mSparseArray[mDenseArray.matchingEntityIndexes.back()] = idx;
-							mDenseArray.cachedComponents[idx] = mDenseArray.cachedComponents.back();
-							mDenseArray.matchingEntityIndexes[idx] = mDenseArray.matchingEntityIndexes.back();
+							// keep the enabled entries contiguous
+							--mDenseArray.enabledCount;
+							swapEntries(idx, mDenseArray.enabledCount);
+							idx = mDenseArray.enabledCount;
 						}
+						swapEntries(idx, mDenseArray.matchingEntities.size() - 1);
 						mSparseArray[entityIndex] = BaseIndex::InvalidIndex;
 						mDenseArray.cachedComponents.pop_back();
-						mDenseArray.matchingEntityIndexes.pop_back();
+						mDenseArray.matchingEntities.pop_back();
+						mDenseArray.disabledMasks.pop_back();
 					}
 				}
 			}
 
-			[[nodiscard]] const std::vector<size_t>& getMatchingEntities() const
+			void setComponentEnabled(ComponentTypeId typeId, const size_t entityIndex, const bool isEnabled) override
+			{
+				if (entityIndex >= mSparseArray.size() || mSparseArray[entityIndex] == BaseIndex::InvalidIndex)
+				{
+					return;
+				}
+
+				const size_t idx = mSparseArray[entityIndex];
+				const DisabledMask componentBit = getComponentBit(typeId);
+				const DisabledMask oldMask = mDenseArray.disabledMasks[idx];
+				const DisabledMask newMask = isEnabled ? (oldMask & ~componentBit) : (oldMask | componentBit);
+				mDenseArray.disabledMasks[idx] = newMask;
+
+				if (oldMask == 0 && newMask != 0)
+				{
+					// move to the beginning of the disabled part
+					--mDenseArray.enabledCount;
+					swapEntries(idx, mDenseArray.enabledCount);
+				}
+				else if (oldMask != 0 && newMask == 0)
+				{
+					// move to the end of the enabled part
+					swapEntries(idx, mDenseArray.enabledCount);
+					++mDenseArray.enabledCount;
+				}
+			}
+
+			void updateComponentPointer(ComponentTypeId typeId, const size_t entityIndex, void* newComponent) override
+			{
+				if (entityIndex >= mSparseArray.size() || mSparseArray[entityIndex] == BaseIndex::InvalidIndex)
+				{
+					return;
+				}
+
+				setComponentPointer(mDenseArray.cachedComponents[mSparseArray[entityIndex]], typeId, newComponent, std::index_sequence_for<Components...>{});
+			}
+
+			void remapEntities(std::span<const Entity::RawId> newIdxByOldIdx, const EntitySlots& entitySlots) override
 			{
-				return mDenseArray.matchingEntityIndexes;
+				size_t sparseArraySize = 0;
+				for (Entity& entity : mDenseArray.matchingEntities)
+				{
+					entity = entitySlots.makeEntity(newIdxByOldIdx[entity.getRawId()]);
+					// have to use this weird syntax because it otherwise can break on MSVC is someone
+					// inludes <windows.h> before this file without NOMINMAX defined
+					sparseArraySize = (std::max)(sparseArraySize, static_cast<size_t>(entity.getRawId()) + 1);
+				}
+
+				// a new array to release the memory of the old one
+				std::vector<size_t> sparseArray(sparseArraySize, BaseIndex::InvalidIndex);
+				for (size_t idx = 0; idx < mDenseArray.matchingEntities.size(); ++idx)
+				{
+					sparseArray[mDenseArray.matchingEntities[idx].getRawId()] = idx;
+				}
+				mSparseArray = std::move(sparseArray);
+			}
+
+			void sortEntriesByEntities() override
+			{
+				// the enabled and the disabled entries are sorted separately to keep them apart
+				sortEntries(0, mDenseArray.enabledCount);
+				sortEntries(mDenseArray.enabledCount, mDenseArray.matchingEntities.size());
+			}
+
+			[[nodiscard]] std::span<const Entity> getMatchingEntities() const
+			{
+				return { mDenseArray.matchingEntities.data(), mDenseArray.enabledCount };
 			}
 
 			[[nodiscard]] size_t getMatchingEntitiesCount() const
 			{
-				return mDenseArray.matchingEntityIndexes.size();
+				return mDenseArray.enabledCount;
 			}
 
-			[[nodiscard]] const std::vector<std::tuple<Components*...>>& getComponents() const
+			[[nodiscard]] std::span<const std::tuple<Components*...>> getComponents() const
 			{
-				return mDenseArray.cachedComponents;
+				return { mDenseArray.cachedComponents.data(), mDenseArray.enabledCount };
 			}
 
 			[[nodiscard]] const std::vector<ComponentTypeId>& getComponentTypes() const
@@ -253,58 +488,192 @@ namespace RaccoonEcs
 				return mComponentTypes;
 			}
 
-			void populate(const ComponentMap& componentMap) override
+			void populate(const ComponentMap& componentMap, const EntitySlots& entitySlots) override
 			{
 				BaseIndex::setPopulated(true);
-				size_t shortestVectorSize = MaxOfSizeType;
-				std::vector<const std::vector<void*>*> componentVectors;
-				componentVectors.reserve(mComponentTypes.size());
-				for (ComponentTypeId typeId : mComponentTypes)
-				{
-					componentVectors.push_back(&componentMap.getComponentVectorById(typeId));
-					// have to use this weird syntax because it otherwise can break on MSVC is someone
-					// inludes <windows.h> before this file without NOMINMAX defined
-					shortestVectorSize = (std::min)(shortestVectorSize, componentVectors.back()->size());
-				}
+				const auto columns = std::make_tuple(componentMap.template getColumn<Components>()...);
+				const size_t shortestColumnSize = std::apply(
+					[](const auto&... column) {
+						// have to use this weird syntax because it otherwise can break on MSVC is someone
+						// inludes <windows.h> before this file without NOMINMAX defined
+						return (std::min)({ column.size()... });
+					},
+					columns
+				);
 
-				if (shortestVectorSize == MaxOfSizeType || shortestVectorSize == 0)
+				if (shortestColumnSize == 0)
 				{
 					return;
 				}
 
-				mSparseArray.resize(shortestVectorSize, BaseIndex::InvalidIndex);
-				for (size_t i = 0u; i < shortestVectorSize; ++i)
+				mSparseArray.resize(shortestColumnSize, BaseIndex::InvalidIndex);
+				for (size_t i = 0u; i < shortestColumnSize; ++i)
 				{
-					if (doesEntityHaveAllComponents(componentVectors, i))
+					const std::tuple<Components*...> components = std::apply(
+						[i](const auto&... column) {
+							return std::tuple<Components*...>(column.get(i)...);
+						},
+						columns
+					);
+
+					if (!hasMissingComponents(components))
 					{
-						using namespace TemplateTrick;
-						mDenseArray.matchingEntityIndexes.push_back(i);
-						mSparseArray[i] = mDenseArray.matchingEntityIndexes.size() - 1;
-						mDenseArray.cachedComponents.emplace_back(static_cast<Components*>((*componentVectors[Idx<Components, Components...>()])[i])...);
+						appendEntry(entitySlots.makeEntity(i), components, calculateDisabledMask(componentMap, i));
 					}
 				}
 			}
 
-			void repopulate(const ComponentMap& componentMap) override
+			void repopulate(const ComponentMap& componentMap, const EntitySlots& entitySlots) override
 			{
 				clear();
-				populate(componentMap);
+				populate(componentMap, entitySlots);
+			}
+
+			[[nodiscard]] std::unique_ptr<BaseIndex> clone(const ComponentMap& componentMap) const override
+			{
+				std::unique_ptr<Index> indexCopy = std::make_unique<Index>();
+				indexCopy->setPopulated(BaseIndex::isPopulated());
+				indexCopy->mSparseArray = mSparseArray;
+				indexCopy->mDenseArray.matchingEntities = mDenseArray.matchingEntities;
+				indexCopy->mDenseArray.disabledMasks = mDenseArray.disabledMasks;
+				indexCopy->mDenseArray.enabledCount = mDenseArray.enabledCount;
+
+				// the entries keep the same order, only the component pointers are taken from the new map
+				const auto columns = std::make_tuple(componentMap.template getColumn<Components>()...);
+				std::vector<std::tuple<Components*...>>& cachedComponents = indexCopy->mDenseArray.cachedComponents;
+				cachedComponents.reserve(mDenseArray.matchingEntities.size());
+				for (const Entity entity : mDenseArray.matchingEntities)
+				{
+					const size_t entityIndex = static_cast<size_t>(entity.getRawId());
+					cachedComponents.push_back(std::apply(
+						[entityIndex](const auto&... column) {
+							return std::tuple<Components*...>(column.get(entityIndex)...);
+						},
+						columns
+					));
+				}
+
+				return indexCopy;
 			}
 
 			void clear() override
 			{
 				BaseIndex::setPopulated(false);
-				mDenseArray.matchingEntityIndexes.clear();
+				mDenseArray.matchingEntities.clear();
 				mDenseArray.cachedComponents.clear();
+				mDenseArray.disabledMasks.clear();
+				mDenseArray.enabledCount = 0;
 				mSparseArray.clear();
 			}
 
 		private:
-			static bool doesEntityHaveAllComponents(const std::vector<const std::vector<void*>*>& componentVectors, size_t i)
+			static bool hasMissingComponents(const std::tuple<Components*...>& components)
+			{
+				return std::apply(
+					[](const Components*... component) {
+						return ((component == nullptr) || ...);
+					},
+					components
+				);
+			}
+
+			DisabledMask calculateDisabledMask(const ComponentMap& componentMap, const size_t entityIndex) const
 			{
-				return std::all_of(componentVectors.begin(), componentVectors.end(), [i](const std::vector<void*>* componentVector) {
-					return (*componentVector)[i] != nullptr;
-				});
+				DisabledMask mask = 0;
+				if (componentMap.hasDisabledComponents())
+				{
+					for (size_t i = 0; i < sizeof...(Components); ++i)
+					{
+						if (!componentMap.isComponentEnabled(mComponentTypes[i], entityIndex))
+						{
+							mask |= DisabledMask(1) << i;
+						}
+					}
+				}
+				return mask;
+			}
+
+			template<size_t... Indexes>
+			void setComponentPointer(std::tuple<Components*...>& components, ComponentTypeId typeId, void* newComponent, std::index_sequence<Indexes...>) const
+			{
+				((mComponentTypes[Indexes] == typeId ? static_cast<void>(std::get<Indexes>(components) = static_cast<Components*>(newComponent)) : static_cast<void>(0)), ...);
+			}
+
+			DisabledMask getComponentBit(ComponentTypeId typeId) const
+			{
+				for (size_t i = 0; i < sizeof...(Components); ++i)
+				{
+					if (mComponentTypes[i] == typeId)
+					{
+						return DisabledMask(1) << i;
+					}
+				}
+				return 0;
+			}
+
+			void appendEntry(const Entity entity, const std::tuple<Components*...>& components, const DisabledMask disabledMask)
+			{
+				mSparseArray[entity.getRawId()] = mDenseArray.matchingEntities.size();
+				mDenseArray.cachedComponents.push_back(components);
+				mDenseArray.matchingEntities.push_back(entity);
+				mDenseArray.disabledMasks.push_back(disabledMask);
+
+				if (disabledMask == 0)
+				{
+					swapEntries(mDenseArray.matchingEntities.size() - 1, mDenseArray.enabledCount);
+					++mDenseArray.enabledCount;
+				}
+			}
+
+			void sortEntries(const size_t beginIdx, const size_t endIdx)
+			{
+				const auto isLowerEntity = [this](const size_t idxA, const size_t idxB) {
+					return mDenseArray.matchingEntities[idxA].getRawId() < mDenseArray.matchingEntities[idxB].getRawId();
+				};
+
+				std::vector<size_t> order(endIdx - beginIdx);
+				std::iota(order.begin(), order.end(), beginIdx);
+				if (std::is_sorted(order.begin(), order.end(), isLowerEntity))
+				{
+					return;
+				}
+				std::sort(order.begin(), order.end(), isLowerEntity);
+
+				std::vector<std::tuple<Components*...>> cachedComponents;
+				std::vector<Entity> matchingEntities;
+				std::vector<DisabledMask> disabledMasks;
+				cachedComponents.reserve(order.size());
+				matchingEntities.reserve(order.size());
+				disabledMasks.reserve(order.size());
+				for (const size_t idx : order)
+				{
+					cachedComponents.push_back(mDenseArray.cachedComponents[idx]);
+					matchingEntities.push_back(mDenseArray.matchingEntities[idx]);
+					disabledMasks.push_back(mDenseArray.disabledMasks[idx]);
+				}
+
+				for (size_t i = 0; i < order.size(); ++i)
+				{
+					const size_t idx = beginIdx + i;
+					mDenseArray.cachedComponents[idx] = cachedComponents[i];
+					mDenseArray.matchingEntities[idx] = matchingEntities[i];
+					mDenseArray.disabledMasks[idx] = disabledMasks[i];
+					mSparseArray[matchingEntities[i].getRawId()] = idx;
+				}
+			}
+
+			void swapEntries(const size_t idxA, const size_t idxB)
+			{
+				if (idxA == idxB)
+				{
+					return;
+				}
+
+				std::swap(mDenseArray.cachedComponents[idxA], mDenseArray.cachedComponents[idxB]);
+				std::swap(mDenseArray.matchingEntities[idxA], mDenseArray.matchingEntities[idxB]);
+				std::swap(mDenseArray.disabledMasks[idxA], mDenseArray.disabledMasks[idxB]);
+				mSparseArray[mDenseArray.matchingEntities[idxA].getRawId()] = idxA;
+				mSparseArray[mDenseArray.matchingEntities[idxB].getRawId()] = idxB;
 			}
 
 		private:
@@ -368,7 +737,7 @@ namespace RaccoonEcs
 		};
 
 		template<typename... Components>
-		const Index<Components...>& getOrCreateIndex(const ComponentMap& componentMap)
+		const Index<Components...>& getOrCreateIndex(const ComponentMap& componentMap, const EntitySlots& entitySlots)
 		{
 			static const IndexKey key = IndexKey::template Create<Components...>();
 			if (auto it = mIndexes.find(key); it != mIndexes.end())
@@ -378,7 +747,7 @@ namespace RaccoonEcs
 
 			std::unique_ptr<Index<Components...>> indexPtr = std::make_unique<Index<Components...>>();
 			Index<Components...>& index = *indexPtr;
-			index.populate(componentMap);
+			index.populate(componentMap, entitySlots);
 			for (ComponentTypeId typeId : index.getComponentTypes())
 			{
 				mIndexesHavingComponent[typeId].push_back(&index);
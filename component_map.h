@@ -1,9 +1,17 @@
 #pragma once
 
+#include <algorithm>
+#include <cstddef>
+#include <iterator>
+#include <span>
 #include <tuple>
+#include <type_traits>
 #include <unordered_map>
+#include <utility>
 #include <vector>
 
+#include "dynamic_bitset.h"
+#include "entity.h"
 #include "error_handling.h"
 
 namespace RaccoonEcs
@@ -15,6 +23,80 @@ namespace RaccoonEcs
 		using Iterator = typename std::unordered_map<ComponentTypeId, std::vector<void*>>::iterator;
 		using ConstIterator = typename std::unordered_map<ComponentTypeId, std::vector<void*>>::const_iterator;
 
+		/**
+		 * @brief Storage of a tag (empty) component type, one bit per entity
+		 *
+		 * All tag components of one type share the same instance
+		 */
+		struct TagStorage
+		{
+			DynamicBitset flags;
+			void* instance = nullptr;
+
+			[[nodiscard]] bool test(const size_t entityIdx) const noexcept
+			{
+				return entityIdx < flags.size() && flags.test(entityIdx);
+			}
+		};
+
+		using TagStorageMap = std::unordered_map<ComponentTypeId, TagStorage>;
+
+		/**
+		 * @brief Read access to components of one type that works the same for tags and normal components
+		 *
+		 * Should not outlive the map or be used after components of the type were added or removed
+		 */
+		template<typename ComponentType>
+		class Column
+		{
+		public:
+			explicit Column(const ComponentMapImpl& componentMap)
+			{
+				if constexpr (std::is_empty_v<ComponentType>)
+				{
+					mTags = componentMap.getTagStorageById(ComponentType::GetTypeId());
+				}
+				else
+				{
+					mComponents = &componentMap.getComponentVectorById(ComponentType::GetTypeId());
+				}
+			}
+
+			/**
+			 * @return upper bound of entity indexes that can have the component
+			 */
+			[[nodiscard]] size_t size() const noexcept
+			{
+				if constexpr (std::is_empty_v<ComponentType>)
+				{
+					return mTags ? mTags->flags.size() : 0;
+				}
+				else
+				{
+					return mComponents->size();
+				}
+			}
+
+			/**
+			 * @return the component of the entity or nullptr
+			 */
+			[[nodiscard]] ComponentType* get(const size_t entityIdx) const noexcept
+			{
+				if constexpr (std::is_empty_v<ComponentType>)
+				{
+					return (mTags && mTags->test(entityIdx)) ? static_cast<ComponentType*>(mTags->instance) : nullptr;
+				}
+				else
+				{
+					return entityIdx < mComponents->size() ? static_cast<ComponentType*>((*mComponents)[entityIdx]) : nullptr;
+				}
+			}
+
+		private:
+			const std::vector<void*>* mComponents = nullptr;
+			const TagStorage* mTags = nullptr;
+		};
+
 	public:
 		ComponentMapImpl() = default;
 		ComponentMapImpl(const ComponentMapImpl&) = delete;
@@ -56,6 +138,178 @@ namespace RaccoonEcs
 			return mData[id];
 		}
 
+		template<typename ComponentType>
+		[[nodiscard]] Column<ComponentType> getColumn() const
+		{
+			return Column<ComponentType>(*this);
+		}
+
+		/**
+		 * @return storage of the tag type, or nullptr if components of this type were never added
+		 */
+		[[nodiscard]] const TagStorage* getTagStorageById(ComponentTypeId id) const
+		{
+			if (mTags.empty())
+			{
+				return nullptr;
+			}
+			auto it = mTags.find(id);
+			return it == mTags.end() ? nullptr : &it->second;
+		}
+
+		[[nodiscard]] TagStorage* getTagStorageById(ComponentTypeId id)
+		{
+			return const_cast<TagStorage*>(std::as_const(*this).getTagStorageById(id));
+		}
+
+		[[nodiscard]] TagStorage& getOrCreateTagStorageById(ComponentTypeId id)
+		{
+			return mTags[id];
+		}
+
+		[[nodiscard]] TagStorageMap& getTagStorages() noexcept { return mTags; }
+		[[nodiscard]] const TagStorageMap& getTagStorages() const noexcept { return mTags; }
+
+		/**
+		 * @return true if the entity has the component, works for both tags and normal components
+		 */
+		[[nodiscard]] bool hasComponent(ComponentTypeId id, const size_t entityIdx) const
+		{
+			const std::vector<void*>& componentVector = getComponentVectorById(id);
+			if (entityIdx < componentVector.size() && componentVector[entityIdx] != nullptr)
+			{
+				return true;
+			}
+
+			const TagStorage* tagStorage = getTagStorageById(id);
+			return tagStorage != nullptr && tagStorage->test(entityIdx);
+		}
+
+		/**
+		 * @return false if the component of the given type was disabled for the entity
+		 */
+		[[nodiscard]] bool isComponentEnabled(ComponentTypeId id, const size_t entityIdx) const
+		{
+			if (mDisabledComponents.empty())
+			{
+				return true;
+			}
+
+			auto it = mDisabledComponents.find(id);
+			return it == mDisabledComponents.end() || entityIdx >= it->second.size() || !it->second.test(entityIdx);
+		}
+
+		void setComponentEnabled(ComponentTypeId id, const size_t entityIdx, const bool isEnabled)
+		{
+			if (isEnabled)
+			{
+				if (auto it = mDisabledComponents.find(id); it != mDisabledComponents.end() && entityIdx < it->second.size())
+				{
+					it->second.reset(entityIdx);
+				}
+			}
+			else
+			{
+				DynamicBitset& disabledFlags = mDisabledComponents[id];
+				if (disabledFlags.size() <= entityIdx)
+				{
+					disabledFlags.resize(entityIdx + 1);
+				}
+				disabledFlags.set(entityIdx);
+			}
+		}
+
+		/**
+		 * @return true if at least one component of any type was ever disabled
+		 */
+		[[nodiscard]] bool hasDisabledComponents() const noexcept
+		{
+			return !mDisabledComponents.empty();
+		}
+
+		/**
+		 * @return flags of disabled components of the given type, or nullptr if none was disabled
+		 */
+		[[nodiscard]] const DynamicBitset* getDisabledFlags(ComponentTypeId id) const
+		{
+			auto it = mDisabledComponents.find(id);
+			return it == mDisabledComponents.end() ? nullptr : &it->second;
+		}
+
+		void setDisabledFlags(ComponentTypeId id, DynamicBitset&& disabledFlags)
+		{
+			mDisabledComponents[id] = std::move(disabledFlags);
+		}
+
+		/**
+		 * @brief Enables back all components of the given entity, e.g. when the entity is removed
+		 */
+		void resetEnabledState(const size_t entityIdx)
+		{
+			for (auto& [id, disabledFlags] : mDisabledComponents)
+			{
+				if (entityIdx < disabledFlags.size())
+				{
+					disabledFlags.reset(entityIdx);
+				}
+			}
+		}
+
+		template<typename ComponentTypeFilter>
+		void copyEnabledStateFrom(const ComponentMapImpl& other, const ComponentTypeFilter& shouldCopyType)
+		{
+			for (const auto& [id, disabledFlags] : other.mDisabledComponents)
+			{
+				if (shouldCopyType(id))
+				{
+					mDisabledComponents[id] = disabledFlags;
+				}
+			}
+		}
+
+		void clearEnabledState()
+		{
+			mDisabledComponents.clear();
+		}
+
+		/**
+		 * @brief Moves the components and their enabled state to new entity indexes and releases the unused memory
+		 * @param oldIdxByNewIdx  Old index for every new index, ascending, indexes that get no entity have an out of range value
+		 *
+		 * Components of other indexes should be already removed
+		 */
+		void compactEntities(std::span<const Entity::RawId> oldIdxByNewIdx)
+		{
+			// each element is moved to a lower or the same index, so the sources are not overwritten before they are read
+			for (auto& [id, componentVector] : mData)
+			{
+				// have to use this weird syntax because it otherwise can break on MSVC is someone
+				// inludes <windows.h> before this file without NOMINMAX defined
+				const size_t newSize = (std::min)(componentVector.size(), oldIdxByNewIdx.size());
+				for (size_t newIdx = 0; newIdx < newSize; ++newIdx)
+				{
+					const size_t oldIdx = oldIdxByNewIdx[newIdx];
+					componentVector[newIdx] = oldIdx < componentVector.size() ? componentVector[oldIdx] : nullptr;
+				}
+
+				const auto lastFilledRIt = std::find_if(componentVector.rbegin() + static_cast<ptrdiff_t>(componentVector.size() - newSize), componentVector.rend(), [](const void* component) { return component != nullptr; });
+				componentVector.resize(static_cast<size_t>(std::distance(lastFilledRIt, componentVector.rend())));
+				componentVector.shrink_to_fit();
+			}
+
+			for (auto& [id, tagStorage] : mTags)
+			{
+				compactBitset(tagStorage.flags, oldIdxByNewIdx);
+			}
+
+			for (auto& [id, disabledFlags] : mDisabledComponents)
+			{
+				compactBitset(disabledFlags, oldIdxByNewIdx);
+			}
+
+			cleanEmptyVectors();
+		}
+
 		void cleanEmptyVectors()
 		{
 			for (auto it = mData.begin(), itEnd = mData.end(); it != itEnd;)
@@ -70,15 +324,41 @@ namespace RaccoonEcs
 				}
 			}
 
+			for (auto it = mTags.begin(), itEnd = mTags.end(); it != itEnd;)
+			{
+				if (it->second.flags.empty())
+				{
+					it = mTags.erase(it);
+				}
+				else
+				{
+					++it;
+				}
+			}
+
 			RACCOON_ECS_ASSERT(mEmptyVector.empty(), "mEmptyVector should be empty");
 		}
 
+		// iterates over vectors of normal components, tag components are accessed with getTagStorages
 		[[nodiscard]] Iterator begin() noexcept { return mData.begin(); }
 		[[nodiscard]] Iterator end() noexcept { return mData.end(); }
 		[[nodiscard]] ConstIterator begin() const noexcept { return mData.cbegin(); }
 		[[nodiscard]] ConstIterator end() const noexcept { return mData.cend(); }
 
 	private:
+		static void compactBitset(DynamicBitset& bitset, std::span<const Entity::RawId> oldIdxByNewIdx)
+		{
+			const size_t newSize = (std::min)(bitset.size(), oldIdxByNewIdx.size());
+			for (size_t newIdx = 0; newIdx < newSize; ++newIdx)
+			{
+				const size_t oldIdx = oldIdxByNewIdx[newIdx];
+				bitset.assign(newIdx, oldIdx < bitset.size() && bitset.test(oldIdx));
+			}
+			bitset.resize(newSize);
+			bitset.shrinkToLastSetBit();
+			bitset.shrinkToFit();
+		}
+
 		template<int I = 0>
 		static std::tuple<> getEmptyComponentVectors()
 		{
@@ -100,6 +380,9 @@ namespace RaccoonEcs
 	private:
 		std::unordered_map<ComponentTypeId, std::vector<void*>> mData;
 		std::vector<void*> mEmptyVector;
+		TagStorageMap mTags;
+		// stored only for types that had components disabled at least once
+		std::unordered_map<ComponentTypeId, DynamicBitset> mDisabledComponents;
 	};
 
 } // namespace RaccoonEcs
@@ -1,14 +1,85 @@
 #pragma once
 
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
 #include <functional>
+#include <memory>
+#include <type_traits>
 #include <vector>
 
+#include "error_handling.h"
+
+#if defined(RACCOON_ECS_COPY_ON_WRITE_COMPONENTS) && !defined(RACCOON_ECS_COPYABLE_COMPONENTS)
+#error "RACCOON_ECS_COPY_ON_WRITE_COMPONENTS requires RACCOON_ECS_COPYABLE_COMPONENTS to be defined"
+#endif
+
 namespace RaccoonEcs
 {
 	class ComponentPoolBase
 	{
 	public:
 		virtual ~ComponentPoolBase() = default;
+
+		/**
+		 * @brief Releases the chunks of memory that have no acquired components
+		 * @return amount of component slots that were released
+		 */
+		virtual size_t trim() = 0;
+		/**
+		 * @brief Makes the pool trim itself when releasing a component leaves the given amount of free slots,
+		 * 0 disables automatic trimming
+		 *
+		 * After each attempt the next one happens only when another freeSlotsThreshold slots become free,
+		 * so memory that can't be released doesn't make every release of a component slow.
+		 * Automatic trimming releases a chunk only if at least freeSlotsThreshold free slots remain after that,
+		 * so adding and removing a component at a chunk boundary doesn't allocate and release a chunk every time
+		 */
+		virtual void setAutoTrimThreshold(size_t freeSlotsThreshold) = 0;
+
+		/**
+		 * @brief Slots reserved for one relocation pass, owned by the caller of reserveRelocationSlots,
+		 * so several passes over the same pool don't take slots from each other
+		 */
+		struct RelocationSlots
+		{
+			void* next = nullptr;
+			void* end = nullptr;
+		};
+
+		/**
+		 * @brief Reserves consecutive slots of a new chunk, so relocateComponent can move the given amount of components there
+		 */
+		[[nodiscard]] virtual RelocationSlots reserveRelocationSlots(size_t componentsCount) = 0;
+		/**
+		 * @brief Moves the component to the next slot of the given relocation slots and releases its old slot,
+		 * the relocation slots are taken in the order of their addresses, when they run out
+		 * chunks of the default chunk size are reserved
+		 * @return new address of the component, or the old one if the component can't be moved
+		 */
+		virtual void* relocateComponent(RelocationSlots& relocationSlots, void* component) = 0;
+		/**
+		 * @brief Returns the relocation slots that were not used to the free list
+		 */
+		virtual void finishRelocation(RelocationSlots& relocationSlots) = 0;
+		/**
+		 * @return true if the components that are not nullptr occupy consecutive slots in the order of the vector
+		 */
+		[[nodiscard]] virtual bool areComponentsContiguous(const std::vector<void*>& components) const = 0;
+
+#ifdef RACCOON_ECS_COPY_ON_WRITE_COMPONENTS
+		/**
+		 * @brief Adds one more owner to each of the given components, nullptr elements are skipped
+		 */
+		virtual void shareComponents(const std::vector<void*>& components) = 0;
+		/**
+		 * @return the component itself if it has only one owner, otherwise a new copy of it
+		 * that replaces the component for the calling owner
+		 */
+		virtual void* makeComponentUnique(void* component) = 0;
+		[[nodiscard]] virtual bool hasSharedComponents() const = 0;
+#endif // RACCOON_ECS_COPY_ON_WRITE_COMPONENTS
 	};
 
 	template<typename ComponentType>
@@ -31,9 +102,9 @@ namespace RaccoonEcs
 		~ComponentPool() override
 		{
 			// we assume that all the components were unregistered before component pool destruction
-			for (const ComponentSlot* chunk : mChunks)
+			for (const Chunk& chunk : mChunks)
 			{
-				delete[] chunk;
+				delete[] chunk.slots;
 			}
 		}
 
@@ -52,19 +123,324 @@ namespace RaccoonEcs
 
 			ComponentSlot* takenSlot = mNextFreeSlot;
 			mNextFreeSlot = takenSlot->nextFreeSlot;
+			--mFreeSlotsCount;
+#ifdef RACCOON_ECS_COPY_ON_WRITE_COMPONENTS
+			takenSlot->refCount = 1;
+#endif // RACCOON_ECS_COPY_ON_WRITE_COMPONENTS
 
 			return new (&takenSlot->component) ComponentType(std::forward<Args>(constructorArguments)...);
 		}
 
+		/**
+		 * @brief Makes sure that the given amount of components can be acquired without allocations
+		 */
+		void reserve(const size_t componentsCount)
+		{
+			if (mFreeSlotsCount < componentsCount)
+			{
+				// have to use this weird syntax because it otherwise can break on MSVC is someone
+				// inludes <windows.h> before this file without NOMINMAX defined
+				allocateNewChunk((std::max)(getNewChunkSize(), componentsCount - mFreeSlotsCount));
+			}
+		}
+
+		/**
+		 * @brief Creates copies of the given components and writes them to the same positions in destination
+		 * @param source  Pointers to the components of this pool, can contain nullptr
+		 * @param destination  Will be resized to the size of source, nullptr elements stay nullptr
+		 *
+		 * Allocates at most one chunk, trivially copyable components are copied bytewise
+		 */
+		void cloneComponents(const std::vector<void*>& source, std::vector<void*>& destination)
+		{
+			const size_t componentsCount = source.size();
+			const size_t clonedComponentsCount = componentsCount - static_cast<size_t>(std::count(source.begin(), source.end(), nullptr));
+			destination.resize(componentsCount);
+			reserve(clonedComponentsCount);
+
+			for (size_t i = 0; i < componentsCount; ++i)
+			{
+				if (source[i] == nullptr)
+				{
+					destination[i] = nullptr;
+					continue;
+				}
+
+				ComponentSlot* takenSlot = mNextFreeSlot;
+				mNextFreeSlot = takenSlot->nextFreeSlot;
+#ifdef RACCOON_ECS_COPY_ON_WRITE_COMPONENTS
+				takenSlot->refCount = 1;
+#endif // RACCOON_ECS_COPY_ON_WRITE_COMPONENTS
+
+				if constexpr (std::is_trivially_copyable_v<ComponentType>)
+				{
+					std::memcpy(static_cast<void*>(&takenSlot->component), source[i], sizeof(ComponentType));
+					destination[i] = &takenSlot->component;
+				}
+				else
+				{
+					destination[i] = new (&takenSlot->component) ComponentType(*static_cast<const ComponentType*>(source[i]));
+				}
+			}
+			mFreeSlotsCount -= clonedComponentsCount;
+		}
+
+		/**
+		 * @brief Creates components from their bytes stored one after another, e.g. in a saved snapshot
+		 * @param bytes  Bytes of componentsCount components, doesn't need to be aligned
+		 * @param stride  Distance in bytes between the starts of two consecutive components
+		 * @param outComponents  The created components are appended to it in the same order
+		 *
+		 * Allocates at most one chunk, available only for trivially copyable components
+		 */
+		void acquireComponentsFromBytes(const std::byte* bytes, const size_t componentsCount, const size_t stride, std::vector<void*>& outComponents)
+		{
+			static_assert(std::is_trivially_copyable_v<ComponentType>, "Only trivially copyable components can be created from bytes");
+
+			reserve(componentsCount);
+			outComponents.reserve(outComponents.size() + componentsCount);
+			for (size_t i = 0; i < componentsCount; ++i)
+			{
+				ComponentSlot* takenSlot = mNextFreeSlot;
+				mNextFreeSlot = takenSlot->nextFreeSlot;
+#ifdef RACCOON_ECS_COPY_ON_WRITE_COMPONENTS
+				takenSlot->refCount = 1;
+#endif // RACCOON_ECS_COPY_ON_WRITE_COMPONENTS
+
+				std::memcpy(static_cast<void*>(&takenSlot->component), bytes + i * stride, sizeof(ComponentType));
+				outComponents.push_back(&takenSlot->component);
+			}
+			mFreeSlotsCount -= componentsCount;
+		}
+
+		/**
+		 * @brief Uses memory owned by someone else as already acquired components, e.g. a memory-mapped file
+		 * @param slots  Images of componentsCount slots written with writeSlotImage, aligned to getSlotAlignment
+		 * @param memoryOwner  Keeps the memory alive, it is released together with the pool
+		 * @return false if the memory overlaps memory that the pool already uses, nothing is adopted then
+		 *
+		 * The components can be released as usual, their slots are then reused by the pool.
+		 * The same memory can be adopted again only after trim releases it.
+		 * Available only for trivially copyable components
+		 */
+		[[nodiscard]] bool adoptExternalSlots(std::byte* slots, const size_t componentsCount, std::shared_ptr<void>&& memoryOwner)
+		{
+			static_assert(std::is_trivially_copyable_v<ComponentType>, "Only trivially copyable components can use external memory");
+			RACCOON_ECS_ASSERT(reinterpret_cast<std::uintptr_t>(slots) % alignof(ComponentSlot) == 0, "External component slots are not aligned");
+
+			// two owners of the same slots would put them to the free list twice
+			const ComponentSlot* newSlots = reinterpret_cast<const ComponentSlot*>(slots);
+			const bool isOverlapping = std::any_of(mExternalChunks.begin(), mExternalChunks.end(), [newSlots, componentsCount](const ExternalChunk& chunk) {
+				return std::less<const ComponentSlot*>()(newSlots, chunk.slots + chunk.slotsCount) && std::less<const ComponentSlot*>()(chunk.slots, newSlots + componentsCount);
+			});
+			if (isOverlapping)
+			{
+				return false;
+			}
+
+			// external slots are not counted as allocated, so they don't make the next chunks bigger
+			mExternalChunks.push_back({ reinterpret_cast<ComponentSlot*>(slots), componentsCount, std::move(memoryOwner) });
+			return true;
+		}
+
+		[[nodiscard]] constexpr static size_t getSlotSize() noexcept { return sizeof(ComponentSlot); }
+		[[nodiscard]] constexpr static size_t getSlotAlignment() noexcept { return alignof(ComponentSlot); }
+
+		/**
+		 * @brief Writes the bytes of a slot holding a copy of the component, see adoptExternalSlots
+		 * @param outSlot  Place for getSlotSize bytes, doesn't need to be aligned
+		 */
+		static void writeSlotImage(const void* component, std::byte* outSlot)
+		{
+			static_assert(std::is_trivially_copyable_v<ComponentType>, "Only trivially copyable components can use external memory");
+
+			ComponentSlot slotImage;
+			// zero the padding, so the written bytes are deterministic
+			std::memset(static_cast<void*>(&slotImage), 0, sizeof(ComponentSlot));
+			std::memcpy(static_cast<void*>(&slotImage.component), component, sizeof(ComponentType));
+#ifdef RACCOON_ECS_COPY_ON_WRITE_COMPONENTS
+			slotImage.refCount = 1;
+#endif // RACCOON_ECS_COPY_ON_WRITE_COMPONENTS
+			std::memcpy(outSlot, static_cast<const void*>(&slotImage), sizeof(ComponentSlot));
+		}
+
 		void releaseComponent(void* component)
 		{
 			// component is a union part of ComponentSlot, so they have the same address in memory
 			ComponentSlot* slot = static_cast<ComponentSlot*>(component);
+#ifdef RACCOON_ECS_COPY_ON_WRITE_COMPONENTS
+			if (slot->refCount > 1)
+			{
+				// other owners still use the component
+				removeOwner(*slot);
+				return;
+			}
+#endif // RACCOON_ECS_COPY_ON_WRITE_COMPONENTS
 			slot->component.~ComponentType();
 			slot->nextFreeSlot = mNextFreeSlot;
 			mNextFreeSlot = slot;
+			++mFreeSlotsCount;
+
+			if (mAutoTrimThreshold != 0 && mFreeSlotsCount >= mNextAutoTrimFreeSlotsCount)
+			{
+				trimChunks(mAutoTrimThreshold);
+				mNextAutoTrimFreeSlotsCount = mFreeSlotsCount + mAutoTrimThreshold;
+			}
+		}
+
+		size_t trim() override
+		{
+			return trimChunks(0);
+		}
+
+		void setAutoTrimThreshold(const size_t freeSlotsThreshold) override
+		{
+			mAutoTrimThreshold = freeSlotsThreshold;
+			mNextAutoTrimFreeSlotsCount = freeSlotsThreshold;
+		}
+
+		[[nodiscard]] RelocationSlots reserveRelocationSlots(const size_t componentsCount) override
+		{
+			if (componentsCount == 0)
+			{
+				return {};
+			}
+
+			// the chunk is not linked to the free list, so new components don't take the relocation slots
+			ComponentSlot* newChunk = new ComponentSlot[componentsCount];
+			mChunks.push_back({ newChunk, componentsCount });
+			mAllocatedComponentsCount += componentsCount;
+			return { newChunk, newChunk + componentsCount };
 		}
 
+		void* relocateComponent(RelocationSlots& relocationSlots, void* component) override
+		{
+			if constexpr (std::is_trivially_copyable_v<ComponentType> || std::is_move_constructible_v<ComponentType>)
+			{
+				ComponentSlot* slot = static_cast<ComponentSlot*>(component);
+#ifdef RACCOON_ECS_COPY_ON_WRITE_COMPONENTS
+				if (slot->refCount > 1)
+				{
+					// other owners keep pointers to the component
+					return component;
+				}
+#endif // RACCOON_ECS_COPY_ON_WRITE_COMPONENTS
+
+				if (relocationSlots.next == relocationSlots.end)
+				{
+					// components added after the reservation, the growth size of the pool would leave a mostly unused chunk
+					finishRelocation(relocationSlots);
+					relocationSlots = reserveRelocationSlots(mDefaultChunkSize);
+				}
+
+				ComponentSlot* newSlot = static_cast<ComponentSlot*>(relocationSlots.next);
+				relocationSlots.next = newSlot + 1;
+#ifdef RACCOON_ECS_COPY_ON_WRITE_COMPONENTS
+				newSlot->refCount = 1;
+#endif // RACCOON_ECS_COPY_ON_WRITE_COMPONENTS
+
+				if constexpr (std::is_trivially_copyable_v<ComponentType>)
+				{
+					std::memcpy(static_cast<void*>(&newSlot->component), component, sizeof(ComponentType));
+				}
+				else
+				{
+					new (&newSlot->component) ComponentType(std::move(slot->component));
+				}
+				releaseComponent(component);
+				return &newSlot->component;
+			}
+			else
+			{
+				return component;
+			}
+		}
+
+		void finishRelocation(RelocationSlots& relocationSlots) override
+		{
+			// link from the end, so the slots are acquired in the order of their addresses
+			ComponentSlot* nextSlot = static_cast<ComponentSlot*>(relocationSlots.next);
+			for (ComponentSlot* slot = static_cast<ComponentSlot*>(relocationSlots.end); slot != nextSlot;)
+			{
+				--slot;
+				slot->nextFreeSlot = mNextFreeSlot;
+				mNextFreeSlot = slot;
+				++mFreeSlotsCount;
+			}
+			relocationSlots = {};
+		}
+
+		[[nodiscard]] bool areComponentsContiguous(const std::vector<void*>& components) const override
+		{
+			const ComponentSlot* previousSlot = nullptr;
+			for (const void* component : components)
+			{
+				if (component == nullptr)
+				{
+					continue;
+				}
+
+				const ComponentSlot* slot = static_cast<const ComponentSlot*>(component);
+				if (previousSlot != nullptr && slot != previousSlot + 1)
+				{
+					return false;
+				}
+				previousSlot = slot;
+			}
+			return true;
+		}
+
+		/**
+		 * @return amount of component slots in the memory that the pool owns, both acquired and free
+		 */
+		[[nodiscard]] size_t getAllocatedComponentsCount() const noexcept
+		{
+			return mAllocatedComponentsCount;
+		}
+
+#ifdef RACCOON_ECS_COPY_ON_WRITE_COMPONENTS
+		void shareComponents(const std::vector<void*>& components) override
+		{
+			for (void* component : components)
+			{
+				if (component != nullptr)
+				{
+					ComponentSlot* slot = static_cast<ComponentSlot*>(component);
+					if (slot->refCount == 1)
+					{
+						++mSharedComponentsCount;
+					}
+					++slot->refCount;
+				}
+			}
+		}
+
+		void* makeComponentUnique(void* component) override
+		{
+			ComponentSlot* slot = static_cast<ComponentSlot*>(component);
+			if (slot->refCount == 1)
+			{
+				return component;
+			}
+
+			removeOwner(*slot);
+			return acquireComponent(std::ref(slot->component));
+		}
+
+		[[nodiscard]] bool hasSharedComponents() const override
+		{
+			return mSharedComponentsCount != 0;
+		}
+
+		/**
+		 * @return true if the component is owned by more than one entity manager
+		 */
+		[[nodiscard]] static bool isComponentShared(const void* component) noexcept
+		{
+			return static_cast<const ComponentSlot*>(component)->refCount > 1;
+		}
+#endif // RACCOON_ECS_COPY_ON_WRITE_COMPONENTS
+
 	private:
 		struct ComponentSlot
 		{
@@ -74,6 +450,10 @@ namespace RaccoonEcs
 				ComponentType component;
 				ComponentSlot* nextFreeSlot;
 			};
+#ifdef RACCOON_ECS_COPY_ON_WRITE_COMPONENTS
+			// amount of entity managers that own the component
+			std::uint32_t refCount;
+#endif // RACCOON_ECS_COPY_ON_WRITE_COMPONENTS
 
 			// ReSharper disable once CppPossiblyUninitializedMember
 			ComponentSlot()
@@ -86,7 +466,139 @@ namespace RaccoonEcs
 			}
 		};
 
+		struct Chunk
+		{
+			ComponentSlot* slots;
+			size_t slotsCount;
+		};
+
+		// slots living in memory that the pool doesn't own
+		struct ExternalChunk
+		{
+			ComponentSlot* slots;
+			size_t slotsCount;
+			std::shared_ptr<void> memoryOwner;
+		};
+
+		struct ChunkOccupancy
+		{
+			ComponentSlot* slots;
+			size_t slotsCount;
+			size_t freeSlotsCount;
+			size_t chunkIdx;
+			bool isExternal;
+			bool isReleased = false;
+
+			[[nodiscard]] bool isEmpty() const noexcept { return freeSlotsCount == slotsCount; }
+		};
+
 	private:
+		/**
+		 * @brief Releases the chunks that have no acquired components while at least minFreeSlotsCount free slots remain
+		 * @return amount of component slots that were released
+		 */
+		size_t trimChunks(const size_t minFreeSlotsCount)
+		{
+			if (mFreeSlotsCount == 0)
+			{
+				return 0;
+			}
+
+			// count free slots of each chunk, the chunk of a slot is found by its address
+			std::vector<ChunkOccupancy> chunksOccupancy;
+			chunksOccupancy.reserve(mChunks.size() + mExternalChunks.size());
+			for (size_t i = 0; i < mChunks.size(); ++i)
+			{
+				chunksOccupancy.push_back({ mChunks[i].slots, mChunks[i].slotsCount, 0, i, false });
+			}
+			for (size_t i = 0; i < mExternalChunks.size(); ++i)
+			{
+				chunksOccupancy.push_back({ mExternalChunks[i].slots, mExternalChunks[i].slotsCount, 0, i, true });
+			}
+			std::sort(chunksOccupancy.begin(), chunksOccupancy.end(), [](const ChunkOccupancy& a, const ChunkOccupancy& b) {
+				return std::less<const ComponentSlot*>()(a.slots, b.slots);
+			});
+
+			for (ComponentSlot* slot = mNextFreeSlot; slot != nullptr; slot = slot->nextFreeSlot)
+			{
+				findChunkOccupancy(chunksOccupancy, slot).freeSlotsCount++;
+			}
+
+			size_t releasedSlotsCount = 0;
+			for (ChunkOccupancy& chunkOccupancy : chunksOccupancy)
+			{
+				// free slots of an empty chunk are all counted in mFreeSlotsCount, so this doesn't underflow
+				if (chunkOccupancy.isEmpty() && mFreeSlotsCount - releasedSlotsCount - chunkOccupancy.slotsCount >= minFreeSlotsCount)
+				{
+					chunkOccupancy.isReleased = true;
+					releasedSlotsCount += chunkOccupancy.slotsCount;
+				}
+			}
+			if (releasedSlotsCount == 0)
+			{
+				return 0;
+			}
+
+			// unlink the slots of the released chunks from the free list, keeping the order of the other slots
+			ComponentSlot** nextFreeSlotLink = &mNextFreeSlot;
+			for (ComponentSlot* slot = mNextFreeSlot; slot != nullptr; slot = slot->nextFreeSlot)
+			{
+				if (!findChunkOccupancy(chunksOccupancy, slot).isReleased)
+				{
+					*nextFreeSlotLink = slot;
+					nextFreeSlotLink = &slot->nextFreeSlot;
+				}
+			}
+			*nextFreeSlotLink = nullptr;
+
+			std::vector<bool> isChunkReleased(mChunks.size(), false);
+			std::vector<bool> isExternalChunkReleased(mExternalChunks.size(), false);
+			for (const ChunkOccupancy& chunkOccupancy : chunksOccupancy)
+			{
+				if (chunkOccupancy.isReleased)
+				{
+					(chunkOccupancy.isExternal ? isExternalChunkReleased : isChunkReleased)[chunkOccupancy.chunkIdx] = true;
+					if (!chunkOccupancy.isExternal)
+					{
+						delete[] chunkOccupancy.slots;
+						mAllocatedComponentsCount -= chunkOccupancy.slotsCount;
+					}
+				}
+			}
+			mFreeSlotsCount -= releasedSlotsCount;
+
+			eraseReleased(mChunks, isChunkReleased);
+			// releases the external memory if nothing else holds it
+			eraseReleased(mExternalChunks, isExternalChunkReleased);
+			return releasedSlotsCount;
+		}
+
+		/**
+		 * @param chunksOccupancy  Sorted by the addresses of the chunks
+		 */
+		static ChunkOccupancy& findChunkOccupancy(std::vector<ChunkOccupancy>& chunksOccupancy, const ComponentSlot* slot)
+		{
+			auto it = std::upper_bound(chunksOccupancy.begin(), chunksOccupancy.end(), slot, [](const ComponentSlot* searchedSlot, const ChunkOccupancy& chunkOccupancy) {
+				return std::less<const ComponentSlot*>()(searchedSlot, chunkOccupancy.slots);
+			});
+			RACCOON_ECS_ASSERT(it != chunksOccupancy.begin(), "Free component slot doesn't belong to any chunk");
+			return *(it - 1);
+		}
+
+		template<typename ChunkType>
+		static void eraseReleased(std::vector<ChunkType>& chunks, const std::vector<bool>& isReleased)
+		{
+			size_t keptChunksCount = 0;
+			for (size_t i = 0; i < chunks.size(); ++i)
+			{
+				if (!isReleased[i])
+				{
+					chunks[keptChunksCount++] = std::move(chunks[i]);
+				}
+			}
+			chunks.resize(keptChunksCount);
+		}
+
 		[[nodiscard]] size_t getNewChunkSize() const
 		{
 			if (mAllocatedComponentsCount == 0)
@@ -102,13 +614,27 @@ namespace RaccoonEcs
 			return mAllocatedComponentsCount * 2;
 		}
 
+#ifdef RACCOON_ECS_COPY_ON_WRITE_COMPONENTS
+		void removeOwner(ComponentSlot& slot) noexcept
+		{
+			--slot.refCount;
+			if (slot.refCount == 1)
+			{
+				--mSharedComponentsCount;
+			}
+		}
+#endif // RACCOON_ECS_COPY_ON_WRITE_COMPONENTS
+
 		void allocateNewChunk()
 		{
-			const size_t newChunkSize = getNewChunkSize();
+			allocateNewChunk(getNewChunkSize());
+		}
 
-			mChunks.push_back(new (std::nothrow) ComponentSlot[newChunkSize]);
+		void allocateNewChunk(const size_t newChunkSize)
+		{
+			ComponentSlot* newChunk = new (std::nothrow) ComponentSlot[newChunkSize];
+			mChunks.push_back({ newChunk, newChunkSize });
 
-			ComponentSlot* newChunk = mChunks.back();
 			for (size_t i = 0; i < newChunkSize - 1; ++i)
 			{
 				newChunk[i].nextFreeSlot = &newChunk[i + 1];
@@ -118,12 +644,20 @@ namespace RaccoonEcs
 			mNextFreeSlot = &newChunk[0];
 
 			mAllocatedComponentsCount += newChunkSize;
+			mFreeSlotsCount += newChunkSize;
 		}
 
 	private:
 		ComponentSlot* mNextFreeSlot = nullptr;
-		std::vector<ComponentSlot*> mChunks;
+		std::vector<Chunk> mChunks;
 		size_t mAllocatedComponentsCount = 0;
+		size_t mFreeSlotsCount = 0;
+		std::vector<ExternalChunk> mExternalChunks;
+		size_t mAutoTrimThreshold = 0;
+		size_t mNextAutoTrimFreeSlotsCount = 0;
+#ifdef RACCOON_ECS_COPY_ON_WRITE_COMPONENTS
+		size_t mSharedComponentsCount = 0;
+#endif // RACCOON_ECS_COPY_ON_WRITE_COMPONENTS
 		const size_t mDefaultChunkSize;
 		std::function<size_t(size_t)> mGrowStrategyFn;
 	};
@@ -1,6 +1,12 @@
 #pragma once
 
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
 #include <functional>
+#include <new>
+#include <type_traits>
+#include <utility>
 #include <vector>
 
 #include "error_handling.h"
@@ -67,6 +73,173 @@ namespace RaccoonEcs
 		FunctionType mFunction;
 	};
 
+	// by default big enough to store a std::function, so it can be passed as a callable as well
+	constexpr size_t DefaultInplaceFunctionCapacity = sizeof(std::function<void()>);
+
+	template<typename Signature, size_t Capacity = DefaultInplaceFunctionCapacity>
+	class InplaceFunction;
+
+	/**
+	 * @brief Type-erased callable that stores the callable object inline and never allocates
+	 *
+	 * Callables that don't fit into Capacity are rejected at compile time.
+	 * Trivially copyable callables (function pointers, lambdas capturing pointers or references)
+	 * are copied and destroyed without any indirect calls.
+	 */
+	template<typename Result, typename... Args, size_t Capacity>
+	class InplaceFunction<Result(Args...), Capacity>
+	{
+	public:
+		InplaceFunction() noexcept = default;
+		// ReSharper disable once CppNonExplicitConvertingConstructor
+		InplaceFunction(std::nullptr_t) noexcept {} // NOLINT(*-explicit-constructor)
+
+		// implicit conversion from callables
+		// ReSharper disable once CppNonExplicitConvertingConstructor
+		template<typename Callable, typename = std::enable_if_t<!std::is_same_v<std::decay_t<Callable>, InplaceFunction> && std::is_invocable_r_v<Result, std::decay_t<Callable>&, Args...>>>
+		InplaceFunction(Callable&& callable) // NOLINT(*-explicit-constructor)
+		{
+			using StoredType = std::decay_t<Callable>;
+			static_assert(sizeof(StoredType) <= Capacity, "Callable is too big to be stored inline, increase Capacity");
+			static_assert(alignof(StoredType) <= alignof(std::max_align_t), "Callable has unsupported alignment");
+
+			if constexpr (std::is_constructible_v<bool, const StoredType&>)
+			{
+				// empty function pointers and std::functions produce empty InplaceFunction
+				if (!static_cast<bool>(callable))
+				{
+					return;
+				}
+			}
+
+			new (&mStorage) StoredType(std::forward<Callable>(callable));
+			mInvokeFn = [](void* storage, Args&&... args) -> Result {
+				return (*static_cast<StoredType*>(storage))(std::forward<Args>(args)...);
+			};
+			if constexpr (!std::is_trivially_copyable_v<StoredType>)
+			{
+				mManageFn = &manage<StoredType>;
+			}
+		}
+
+		InplaceFunction(const InplaceFunction& other)
+		{
+			copyFrom(other);
+		}
+
+		InplaceFunction(InplaceFunction&& other) noexcept
+		{
+			moveFrom(other);
+		}
+
+		InplaceFunction& operator=(const InplaceFunction& other)
+		{
+			if (this != &other)
+			{
+				reset();
+				copyFrom(other);
+			}
+			return *this;
+		}
+
+		InplaceFunction& operator=(InplaceFunction&& other) noexcept
+		{
+			if (this != &other)
+			{
+				reset();
+				moveFrom(other);
+			}
+			return *this;
+		}
+
+		~InplaceFunction()
+		{
+			reset();
+		}
+
+		explicit operator bool() const noexcept { return mInvokeFn != nullptr; }
+
+		Result operator()(Args... args) const
+		{
+			return mInvokeFn(&mStorage, std::forward<Args>(args)...);
+		}
+
+		void reset() noexcept
+		{
+			if (mManageFn)
+			{
+				mManageFn(Operation::Destroy, &mStorage, nullptr);
+			}
+			mInvokeFn = nullptr;
+			mManageFn = nullptr;
+		}
+
+	private:
+		enum class Operation
+		{
+			Copy,
+			Move,
+			Destroy
+		};
+
+		using InvokeFn = Result (*)(void*, Args&&...);
+		using ManageFn = void (*)(Operation, void*, void*);
+
+		template<typename StoredType>
+		static void manage(const Operation operation, void* destination, void* source)
+		{
+			switch (operation)
+			{
+			case Operation::Copy:
+				new (destination) StoredType(*static_cast<const StoredType*>(source));
+				break;
+			case Operation::Move:
+				new (destination) StoredType(std::move(*static_cast<StoredType*>(source)));
+				static_cast<StoredType*>(source)->~StoredType();
+				break;
+			case Operation::Destroy:
+				static_cast<StoredType*>(destination)->~StoredType();
+				break;
+			}
+		}
+
+		void copyFrom(const InplaceFunction& other)
+		{
+			if (other.mManageFn)
+			{
+				other.mManageFn(Operation::Copy, &mStorage, &other.mStorage);
+			}
+			else
+			{
+				std::memcpy(&mStorage, &other.mStorage, Capacity);
+			}
+			mInvokeFn = other.mInvokeFn;
+			mManageFn = other.mManageFn;
+		}
+
+		void moveFrom(InplaceFunction& other) noexcept
+		{
+			if (other.mManageFn)
+			{
+				other.mManageFn(Operation::Move, &mStorage, &other.mStorage);
+			}
+			else
+			{
+				std::memcpy(&mStorage, &other.mStorage, Capacity);
+			}
+			mInvokeFn = other.mInvokeFn;
+			mManageFn = other.mManageFn;
+			other.mInvokeFn = nullptr;
+			other.mManageFn = nullptr;
+		}
+
+	private:
+		alignas(std::max_align_t) mutable std::byte mStorage[Capacity];
+		InvokeFn mInvokeFn = nullptr;
+		// nullptr for trivially copyable callables
+		ManageFn mManageFn = nullptr;
+	};
+
 	namespace Delegates
 	{
 		class Handle
@@ -84,17 +257,25 @@ namespace RaccoonEcs
 			}
 
 			bool operator!=(const Handle& b) const { return !(*this == b); }
+			bool operator<(const Handle& b) const { return mIndex < b.mIndex; }
 
 		private:
 			int mIndex = -1;
 		};
 	} // namespace Delegates
 
+	/**
+	 * @brief Delegate that can have multiple bound functions
+	 *
+	 * Functions are stored inline without heap allocations per bound function,
+	 * broadcasting doesn't copy them and costs only a size check when nothing is bound.
+	 * For listeners known at compile time use StaticMulticastDelegate.
+	 */
 	template<typename... Args>
 	class MulticastDelegate
 	{
 	public:
-		using FunctionType = std::function<void(Args...)>;
+		using FunctionType = InplaceFunction<void(Args...)>;
 
 	public:
 		MulticastDelegate() = default;
@@ -129,7 +310,7 @@ namespace RaccoonEcs
 			{
 				RACCOON_ECS_ASSERT(mNextFunctionId <= 10000, "Too many bindings to one delegate, possibility of overflow in the future");
 				Delegates::Handle newHandle(mNextFunctionId++);
-				mFunctions.emplace_back(newHandle, fn);
+				mFunctions.emplace_back(newHandle, std::move(fn));
 				return newHandle;
 			}
 			return {};
@@ -137,24 +318,38 @@ namespace RaccoonEcs
 
 		void unbind(Delegates::Handle handle)
 		{
-			mFunctions.erase(
-				std::remove_if(
-					mFunctions.begin(),
-					mFunctions.end(),
-					[handle](FunctionData& val) {
-						return val.handle == handle;
-					}
-				),
-				mFunctions.end()
+			// handles are increasing, so the functions are always sorted by them
+			auto it = std::lower_bound(
+				mFunctions.begin(),
+				mFunctions.end(),
+				handle,
+				[](const FunctionData& val, const Delegates::Handle searchedHandle) {
+					return val.handle < searchedHandle;
+				}
 			);
+
+			if (it != mFunctions.end() && it->handle == handle)
+			{
+				mFunctions.erase(it);
+			}
+		}
+
+		[[nodiscard]] bool isBound() const noexcept
+		{
+			return !mFunctions.empty();
 		}
 
 		template<typename... CallArgs>
-		void broadcast(CallArgs&&... args)
+		void broadcast(CallArgs&&... args) const
 		{
-			for (auto fnData : mFunctions)
+			if (mFunctions.empty())
+			{
+				return;
+			}
+
+			for (const FunctionData& fnData : mFunctions)
 			{
-				fnData.fn(std::forward<CallArgs>(args)...);
+				fnData.fn(args...);
 			}
 		}
 
@@ -166,9 +361,9 @@ namespace RaccoonEcs
 	private:
 		struct FunctionData
 		{
-			FunctionData(const Delegates::Handle handle, FunctionType fn)
+			FunctionData(const Delegates::Handle handle, FunctionType&& fn)
 				: handle(handle)
-				, fn(fn)
+				, fn(std::move(fn))
 			{}
 
 			Delegates::Handle handle;
@@ -180,4 +375,27 @@ namespace RaccoonEcs
 		int mNextFunctionId = 0;
 	};
 
+	/**
+	 * @brief Delegate with the listeners bound at compile time
+	 *
+	 * Listeners are free functions or static member functions passed as template arguments,
+	 * broadcast calls them directly and compiles to nothing when the list is empty,
+	 * so optional callbacks can be turned off without any runtime cost.
+	 */
+	template<auto... Listeners>
+	class StaticMulticastDelegate
+	{
+	public:
+		[[nodiscard]] static constexpr bool isBound() noexcept
+		{
+			return sizeof...(Listeners) > 0;
+		}
+
+		template<typename... CallArgs>
+		static void broadcast(CallArgs&&... args)
+		{
+			(std::invoke(Listeners, args...), ...);
+		}
+	};
+
 } // namespace RaccoonEcs
@@ -0,0 +1,201 @@
+#pragma once
+
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+#include "error_handling.h"
+
+namespace RaccoonEcs
+{
+	/**
+	 * @brief Resizable set of bits packed into 64-bit words
+	 *
+	 * Unlike std::vector<bool> gives access to the underlying words, so scans can
+	 * skip empty words and use popcount/ctz instead of testing bits one by one
+	 */
+	class DynamicBitset
+	{
+	public:
+		using Word = std::uint64_t;
+		constexpr static size_t BitsPerWord = 64;
+
+	public:
+		[[nodiscard]] size_t size() const noexcept { return mSize; }
+		[[nodiscard]] bool empty() const noexcept { return mSize == 0; }
+
+		/**
+		 * @brief Changes the amount of stored bits, newly added bits are unset
+		 */
+		void resize(const size_t newSize)
+		{
+			if (newSize < mSize)
+			{
+				mWords.resize(getWordsCount(newSize));
+				// keep the bits after the end unset, so the word scans don't need to mask them
+				if (const size_t tailBits = newSize % BitsPerWord; tailBits != 0)
+				{
+					mWords.back() &= (Word(1) << tailBits) - 1;
+				}
+			}
+			else
+			{
+				mWords.resize(getWordsCount(newSize), 0);
+			}
+			mSize = newSize;
+		}
+
+		void pushBack(const bool value)
+		{
+			if (mSize % BitsPerWord == 0)
+			{
+				mWords.push_back(0);
+			}
+			++mSize;
+			if (value)
+			{
+				set(mSize - 1);
+			}
+		}
+
+		/**
+		 * @brief Removes unset bits that go after the last set bit
+		 */
+		void shrinkToLastSetBit()
+		{
+			size_t usedWordsCount = mWords.size();
+			while (usedWordsCount > 0 && mWords[usedWordsCount - 1] == 0)
+			{
+				--usedWordsCount;
+			}
+
+			if (usedWordsCount == 0)
+			{
+				clear();
+				return;
+			}
+
+			const Word lastWord = mWords[usedWordsCount - 1];
+			resize((usedWordsCount - 1) * BitsPerWord + (BitsPerWord - static_cast<size_t>(std::countl_zero(lastWord))));
+		}
+
+		void clear() noexcept
+		{
+			mWords.clear();
+			mSize = 0;
+		}
+
+		/**
+		 * @brief Releases the memory that is not needed to store the current bits
+		 */
+		void shrinkToFit()
+		{
+			mWords.shrink_to_fit();
+		}
+
+		[[nodiscard]] bool test(const size_t idx) const noexcept
+		{
+			RACCOON_ECS_ASSERT(idx < mSize, "Bit index is out of bounds");
+			return (mWords[idx / BitsPerWord] >> (idx % BitsPerWord)) & 1u;
+		}
+
+		void set(const size_t idx) noexcept
+		{
+			RACCOON_ECS_ASSERT(idx < mSize, "Bit index is out of bounds");
+			mWords[idx / BitsPerWord] |= Word(1) << (idx % BitsPerWord);
+		}
+
+		void reset(const size_t idx) noexcept
+		{
+			RACCOON_ECS_ASSERT(idx < mSize, "Bit index is out of bounds");
+			mWords[idx / BitsPerWord] &= ~(Word(1) << (idx % BitsPerWord));
+		}
+
+		void assign(const size_t idx, const bool value) noexcept
+		{
+			if (value)
+			{
+				set(idx);
+			}
+			else
+			{
+				reset(idx);
+			}
+		}
+
+		/**
+		 * @return true if at least one bit is set
+		 */
+		[[nodiscard]] bool any() const noexcept
+		{
+			Word accumulated = 0;
+			// no early exit to let the compiler vectorize the loop
+			for (const Word word : mWords)
+			{
+				accumulated |= word;
+			}
+			return accumulated != 0;
+		}
+
+		/**
+		 * @return amount of set bits
+		 */
+		[[nodiscard]] size_t count() const noexcept
+		{
+			size_t result = 0;
+			for (const Word word : mWords)
+			{
+				result += static_cast<size_t>(std::popcount(word));
+			}
+			return result;
+		}
+
+		/**
+		 * @brief Calls the given function with the index of every set bit in ascending order
+		 */
+		template<typename FunctionType>
+		void forEachSetBit(FunctionType&& fn) const
+		{
+			const size_t wordsCount = mWords.size();
+			for (size_t wordIdx = 0; wordIdx < wordsCount; ++wordIdx)
+			{
+				Word word = mWords[wordIdx];
+				while (word != 0)
+				{
+					const size_t bitIdx = static_cast<size_t>(std::countr_zero(word));
+					fn(wordIdx * BitsPerWord + bitIdx);
+					// clear the lowest set bit
+					word &= word - 1;
+				}
+			}
+		}
+
+		[[nodiscard]] const std::vector<Word>& getWords() const noexcept { return mWords; }
+
+		/**
+		 * @brief Replaces the bits with the given words, e.g. when loading previously saved words
+		 */
+		void assignWords(std::vector<Word>&& words, const size_t bitsCount)
+		{
+			RACCOON_ECS_ASSERT(words.size() == getWordsCount(bitsCount), "Amount of words doesn't match the amount of bits");
+			mWords = std::move(words);
+			mSize = bitsCount;
+			// keep the bits after the end unset, so the word scans don't need to mask them
+			if (const size_t tailBits = bitsCount % BitsPerWord; tailBits != 0)
+			{
+				mWords.back() &= (Word(1) << tailBits) - 1;
+			}
+		}
+
+		[[nodiscard]] static size_t getWordsCount(const size_t bitsCount) noexcept
+		{
+			return (bitsCount + BitsPerWord - 1) / BitsPerWord;
+		}
+
+	private:
+		std::vector<Word> mWords;
+		size_t mSize = 0;
+	};
+} // namespace RaccoonEcs
@@ -1,20 +1,38 @@
 #pragma once
 
 #include <algorithm>
+#include <array>
+#include <optional>
 #include <ranges>
+#include <span>
 #include <string>
 #include <tuple>
+#include <type_traits>
+#include <unordered_map>
 
+#include "component_change_ticks.h"
+#include "component_checksum.h"
+#include "component_events.h"
 #include "component_factory.h"
 #include "component_indexes.h"
 #include "component_map.h"
 #include "delegates.h"
 #include "entity.h"
+#include "entity_slots.h"
 #include "error_handling.h"
 #include "typed_component.h"
 
 namespace RaccoonEcs
 {
+	template<typename ComponentTypeId, typename ComponentFactory>
+	class RewindBufferImpl;
+
+	template<typename ComponentTypeId, typename ComponentFactory>
+	class SnapshotSerializerImpl;
+
+	template<typename ComponentTypeId, typename ComponentFactory>
+	class WorldDiffImpl;
+
 	template<typename ComponentTypeId, typename ComponentFactory = ComponentFactoryImpl<ComponentTypeId>>
 	class EntityManagerImpl
 	{
@@ -23,6 +41,9 @@ namespace RaccoonEcs
 		using TypedComponent = TypedComponentImpl<ComponentTypeId>;
 		using ConstTypedComponent = ConstTypedComponentImpl<ComponentTypeId>;
 		using ComponentMap = ComponentMapImpl<ComponentTypeId>;
+		using ComponentEvent = ComponentEventImpl<ComponentTypeId>;
+		using ComponentChangeTicks = ComponentChangeTicksImpl<ComponentTypeId>;
+		using ComponentChecksumCache = ComponentChecksumCacheImpl<ComponentTypeId>;
 
 	public:
 		/**
@@ -41,7 +62,7 @@ namespace RaccoonEcs
 		explicit EntityManagerImpl(const EntityManagerImpl& other)
 			: EntityManagerImpl(other.mComponentFactory)
 		{
-			copyEntitiesFrom(other);
+			copyEntitiesFrom(other, AllComponentTypes{});
 		}
 #else
 		EntityManagerImpl(const EntityManagerImpl&) = delete;
@@ -56,24 +77,9 @@ namespace RaccoonEcs
 		 */
 		Entity addEntity()
 		{
-			Entity::RawId rawEntityId;
-			if (mFreeEntityIds.empty())
-			{
-				RACCOON_ECS_ASSERT(mEntityVersions.size() == mEntityExistanceFlags.size(), "Inconsistent entity vectors");
-				mEntityVersions.push_back(0);
-				mEntityExistanceFlags.push_back(true);
-				rawEntityId = static_cast<Entity::RawId>(mEntityVersions.size() - 1);
-			}
-			else
-			{
-				const size_t freeEntityId = mFreeEntityIds.back();
-				mFreeEntityIds.pop_back();
-				mEntityExistanceFlags[freeEntityId] = true;
-				rawEntityId = static_cast<Entity::RawId>(freeEntityId);
-			}
-
-			onEntityAdded.broadcast();
-			return Entity{ rawEntityId, mEntityVersions[rawEntityId] };
+			const Entity newEntity = mEntitySlots.makeEntity(mEntitySlots.acquire());
+			onEntityAdded.broadcast(newEntity);
+			return newEntity;
 		}
 
 		/**
@@ -84,15 +90,15 @@ namespace RaccoonEcs
 		void removeEntity(const Entity entityToRemove)
 		{
 			const size_t entityToRemoveIdx = static_cast<size_t>(entityToRemove.getRawId());
-			if (entityToRemoveIdx >= mEntityExistanceFlags.size() || !mEntityExistanceFlags[entityToRemoveIdx])
+			if (!mEntitySlots.isAlive(entityToRemoveIdx))
 			{
 				RACCOON_ECS_ERROR(std::string("Trying to remove non-existent entity: ") + std::to_string(entityToRemoveIdx));
 				return;
 			}
 
-			if (mEntityVersions[entityToRemoveIdx] != entityToRemove.getVersion())
+			if (mEntitySlots.getVersion(entityToRemoveIdx) != entityToRemove.getVersion())
 			{
-				RACCOON_ECS_ERROR(std::string("Trying to remove entity that was already removed. id:") + std::to_string(entityToRemoveIdx) + " recorded version:" + std::to_string(mEntityVersions[entityToRemoveIdx]) + " removed version " + std::to_string(entityToRemove.getVersion()));
+				RACCOON_ECS_ERROR(std::string("Trying to remove entity that was already removed. id:") + std::to_string(entityToRemoveIdx) + " recorded version:" + std::to_string(mEntitySlots.getVersion(entityToRemoveIdx)) + " removed version " + std::to_string(entityToRemove.getVersion()));
 				return;
 			}
 
@@ -108,21 +114,26 @@ namespace RaccoonEcs
 						auto deleterFn = mComponentFactory.get().getDeletionFn(componentVector.first);
 						deleterFn(componentPtrRef);
 						componentPtrRef = nullptr;
+						mComponentEvents.record(entityToRemove, componentVector.first, ComponentEventType::Removed);
 					}
 				}
 			}
 
+			for (auto& [typeId, tagStorage] : mComponents.getTagStorages())
+			{
+				if (tagStorage.test(entityToRemoveIdx))
+				{
+					tagStorage.flags.reset(entityToRemoveIdx);
+					mComponentEvents.record(entityToRemove, typeId, ComponentEventType::Removed);
+				}
+			}
+
 			mIndexes.onEntityRemoved(entityToRemoveIdx);
+			mComponents.resetEnabledState(entityToRemoveIdx);
 
-			onEntityRemoved.broadcast();
+			onEntityRemoved.broadcast(entityToRemove);
 
-			mEntityExistanceFlags[entityToRemoveIdx] = false;
-			const Entity::Version newVersion = ++mEntityVersions[entityToRemoveIdx];
-			// if we hit zero, we used up all the versions for this entity id, skip it
-			if (newVersion != 0)
-			{
-				mFreeEntityIds.push_back(entityToRemoveIdx);
-			}
+			mEntitySlots.release(static_cast<Entity::RawId>(entityToRemoveIdx));
 		}
 
 		/**
@@ -130,10 +141,7 @@ namespace RaccoonEcs
 		 */
 		bool hasEntity(const Entity entity)
 		{
-			const size_t rawEntityId = static_cast<size_t>(entity.getRawId());
-			return rawEntityId < mEntityVersions.size()
-				&& mEntityVersions[rawEntityId] == entity.getVersion()
-				&& mEntityExistanceFlags[rawEntityId];
+			return mEntitySlots.isValid(entity);
 		}
 
 		/**
@@ -143,7 +151,53 @@ namespace RaccoonEcs
 		 */
 		[[nodiscard]] bool hasAnyEntity() const
 		{
-			return mEntityVersions.size() != mFreeEntityIds.size();
+			return mEntitySlots.hasAnyAlive();
+		}
+
+		/**
+		 * @brief Returns amount of entities that currently exist in this manager
+		 */
+		[[nodiscard]] size_t getEntitiesCount() const
+		{
+			return mEntitySlots.getAliveCount();
+		}
+
+		/**
+		 * @brief Calls the given function for every existing entity in the order of their ids
+		 * @param fn  Callable accepting Entity
+		 *
+		 * Doesn't allocate, so it is preferable over collectAllEntities when the list is not stored.
+		 * The callable should not add or remove entities of this manager
+		 */
+		template<typename FunctionType>
+		void forEachEntity(FunctionType fn) const
+		{
+			mEntitySlots.forEachAlive([&fn, this](const size_t entityIdx) {
+				fn(mEntitySlots.makeEntity(entityIdx));
+			});
+		}
+
+		/**
+		 * @brief Sets a tag that is stored in the upper bits of versions of the entities created by this manager
+		 * @param tag  Non-zero value that is unique among the managers used together, 0 to remove the tag
+		 *
+		 * Lets CombinedEntityManagerView find the manager of an entity in O(1).
+		 * Can be called only before the first entity is added, copies of the manager get the same tag
+		 */
+		void setEntityTag(const EntitySlots::Tag tag)
+		{
+			if (mEntitySlots.size() != 0)
+			{
+				RACCOON_ECS_ERROR("Trying to change entity tag of a manager that already created entities");
+				return;
+			}
+
+			mEntitySlots.setTag(tag);
+		}
+
+		[[nodiscard]] EntitySlots::Tag getEntityTag() const
+		{
+			return mEntitySlots.getTag();
 		}
 
 		/**
@@ -154,14 +208,10 @@ namespace RaccoonEcs
 		std::vector<Entity> collectAllEntities() const
 		{
 			std::vector<Entity> entities;
-			entities.reserve(mEntityExistanceFlags.size());
-			for (size_t i = 0; i < mEntityExistanceFlags.size(); ++i)
-			{
-				if (mEntityExistanceFlags[i])
-				{
-					entities.emplace_back(static_cast<Entity::RawId>(i), mEntityVersions[i]);
-				}
-			}
+			entities.reserve(mEntitySlots.getAliveCount());
+			forEachEntity([&entities](const Entity entity) {
+				entities.push_back(entity);
+			});
 			return entities;
 		}
 
@@ -173,15 +223,27 @@ namespace RaccoonEcs
 		void getAllEntityComponents(const Entity entity, std::vector<TypedComponent>& outComponents)
 		{
 			const Entity::RawId entityIdx = entity.getRawId();
-			if (entityIdx < mEntityExistanceFlags.size() && mEntityExistanceFlags[entityIdx])
+			if (mEntitySlots.isAlive(entityIdx))
 			{
 				for (auto& componentVector : mComponents)
 				{
 					if (componentVector.second.size() > entityIdx && componentVector.second[entityIdx] != nullptr)
 					{
+#ifdef RACCOON_ECS_COPY_ON_WRITE_COMPONENTS
+						makeComponentUnique(componentVector.first, entityIdx, componentVector.second[entityIdx]);
+#endif // RACCOON_ECS_COPY_ON_WRITE_COMPONENTS
+						mComponentChangeTicks.markChanged(componentVector.first, entityIdx);
 						outComponents.emplace_back(componentVector.first, componentVector.second[entityIdx]);
 					}
 				}
+
+				for (const auto& [typeId, tagStorage] : mComponents.getTagStorages())
+				{
+					if (tagStorage.test(entityIdx))
+					{
+						outComponents.emplace_back(typeId, tagStorage.instance);
+					}
+				}
 			}
 		}
 
@@ -193,7 +255,7 @@ namespace RaccoonEcs
 		void getAllEntityComponents(const Entity entity, std::vector<ConstTypedComponent>& outComponents) const
 		{
 			const Entity::RawId entityIdx = entity.getRawId();
-			if (entityIdx < mEntityExistanceFlags.size() && mEntityExistanceFlags[entityIdx])
+			if (mEntitySlots.isAlive(entityIdx))
 			{
 				for (auto& componentVector : mComponents)
 				{
@@ -202,6 +264,14 @@ namespace RaccoonEcs
 						outComponents.emplace_back(componentVector.first, componentVector.second[entityIdx]);
 					}
 				}
+
+				for (const auto& [typeId, tagStorage] : mComponents.getTagStorages())
+				{
+					if (tagStorage.test(entityIdx))
+					{
+						outComponents.emplace_back(typeId, tagStorage.instance);
+					}
+				}
 			}
 		}
 
@@ -211,10 +281,9 @@ namespace RaccoonEcs
 		[[nodiscard]] bool doesEntityHaveComponent(const Entity entity, ComponentTypeId typeId) const
 		{
 			const Entity::RawId entityIdx = entity.getRawId();
-			if (entityIdx < mEntityExistanceFlags.size() && mEntityExistanceFlags[entityIdx])
+			if (mEntitySlots.isAlive(entityIdx))
 			{
-				const std::vector<void*>& componentVector = mComponents.getComponentVectorById(typeId);
-				return (componentVector.size() > entityIdx && componentVector[entityIdx] != nullptr);
+				return mComponents.hasComponent(typeId, entityIdx);
 			}
 
 			RACCOON_ECS_ERROR(std::string("Trying to check component ") + toString(typeId) + " of non-existing entity: " + std::to_string(entity.getRawId()));
@@ -274,7 +343,7 @@ namespace RaccoonEcs
 		void addComponent(const Entity entity, void* component, ComponentTypeId typeId)
 		{
 			const Entity::RawId entityIdx = entity.getRawId();
-			if (entityIdx >= mEntityExistanceFlags.size() || !mEntityExistanceFlags[entityIdx])
+			if (!mEntitySlots.isAlive(entityIdx))
 			{
 				RACCOON_ECS_ERROR(std::string("Trying to add component ") + toString(typeId) + " to a non-existent entity " + std::to_string(entityIdx));
 				// memory leak here
@@ -297,24 +366,234 @@ namespace RaccoonEcs
 		void removeComponent(const Entity entity, ComponentTypeId typeId)
 		{
 			const Entity::RawId entityIdx = entity.getRawId();
-			if (entityIdx >= mEntityExistanceFlags.size() || !mEntityExistanceFlags[entityIdx])
+			if (!mEntitySlots.isAlive(entityIdx))
 			{
 				RACCOON_ECS_ERROR(std::string("Trying to remove component ") + toString(typeId) + " from a non-existent entity " + std::to_string(entityIdx));
 				return;
 			}
 
-			auto& componentsVector = mComponents.getComponentVectorById(typeId);
+			bool wasRemoved = false;
+			if (auto* tagStorage = mComponents.getTagStorageById(typeId))
+			{
+				// tags share one instance that is never deleted
+				if (tagStorage->test(entityIdx))
+				{
+					tagStorage->flags.reset(entityIdx);
+					wasRemoved = true;
+				}
+			}
+			else
+			{
+				auto& componentsVector = mComponents.getComponentVectorById(typeId);
+
+				if (entityIdx < componentsVector.size())
+				{
+					wasRemoved = componentsVector[entityIdx] != nullptr;
+					auto deleterFn = mComponentFactory.get().getDeletionFn(typeId);
+					deleterFn(componentsVector[entityIdx]);
+					componentsVector[entityIdx] = nullptr;
+				}
+			}
 
-			if (entityIdx < componentsVector.size())
+			if (wasRemoved)
 			{
-				auto deleterFn = mComponentFactory.get().getDeletionFn(typeId);
-				deleterFn(componentsVector[entityIdx]);
-				componentsVector[entityIdx] = nullptr;
+				mComponentEvents.record(mEntitySlots.makeEntity(entityIdx), typeId, ComponentEventType::Removed);
 			}
 
+			mComponents.setComponentEnabled(typeId, entityIdx, true);
 			mIndexes.onComponentRemoved(typeId, entityIdx);
 		}
 
+		/**
+		 * @brief Enables or disables the component of the given type that the entity owns
+		 * @param entity  The entity owning the component
+		 * @param isEnabled  false to exclude the component from queries, true to include it back
+		 *
+		 * Disabled components stay attached to the entity and are still accessible with
+		 * getEntityComponents and getAllEntityComponents, but entities are not matched by
+		 * forEachComponentSet, getComponents and other indexed queries that include the type.
+		 * Toggling doesn't allocate or release the component and is cheaper than removing and adding it.
+		 * Removed components are always re-added as enabled.
+		 *
+		 * Reorders the entries of indexes that include the type, so it must not be called while iterating
+		 * over such an index (e.g. from a forEachComponentSet callback), use scheduleSetComponentEnabled there
+		 */
+		template<typename ComponentType>
+		void setComponentEnabled(const Entity entity, const bool isEnabled)
+		{
+			setComponentEnabled(entity, ComponentType::GetTypeId(), isEnabled);
+		}
+
+		void setComponentEnabled(const Entity entity, ComponentTypeId typeId, const bool isEnabled)
+		{
+			const Entity::RawId entityIdx = entity.getRawId();
+			if (!mEntitySlots.isAlive(entityIdx))
+			{
+				RACCOON_ECS_ERROR(std::string("Trying to change enabled state of component ") + toString(typeId) + " of a non-existent entity " + std::to_string(entityIdx));
+				return;
+			}
+
+			if (!mComponents.hasComponent(typeId, entityIdx))
+			{
+				RACCOON_ECS_ERROR(std::string("Trying to change enabled state of component ") + toString(typeId) + " that entity " + std::to_string(entityIdx) + " doesn't have");
+				return;
+			}
+
+			if (mComponents.isComponentEnabled(typeId, entityIdx) == isEnabled)
+			{
+				return;
+			}
+
+			mComponents.setComponentEnabled(typeId, entityIdx, isEnabled);
+			mIndexes.onComponentEnabledChanged(typeId, entityIdx, isEnabled);
+		}
+
+		/**
+		 * @brief Checks if the component of the given type is enabled
+		 *
+		 * Components are enabled by default, returns true if the entity doesn't have the component
+		 */
+		template<typename ComponentType>
+		[[nodiscard]] bool isComponentEnabled(const Entity entity) const
+		{
+			return isComponentEnabled(entity, ComponentType::GetTypeId());
+		}
+
+		[[nodiscard]] bool isComponentEnabled(const Entity entity, ComponentTypeId typeId) const
+		{
+			return mComponents.isComponentEnabled(typeId, static_cast<size_t>(entity.getRawId()));
+		}
+
+		/**
+		 * @brief Enables or disables recording of additions and removals of components of the given type
+		 *
+		 * Recorded events are accumulated until they are drained or cleared, so a system can update only
+		 * the entities that changed since the last time it consumed the events.
+		 * Events are not recorded when the manager is cleared or overridden by a copy
+		 */
+		template<typename ComponentType>
+		void trackComponentEvents(const bool isTracked = true)
+		{
+			setComponentEventsTracking(ComponentType::GetTypeId(), isTracked);
+		}
+
+		void setComponentEventsTracking(ComponentTypeId typeId, const bool isTracked)
+		{
+			mComponentEvents.setTracking(typeId, isTracked);
+		}
+
+		/**
+		 * @return recorded events of the given component type in the order they happened
+		 */
+		template<typename ComponentType>
+		[[nodiscard]] std::span<const ComponentEvent> getComponentEvents() const
+		{
+			return mComponentEvents.getEvents(ComponentType::GetTypeId());
+		}
+
+		/**
+		 * @brief Calls the given function for each recorded event of the given component type
+		 * in the order they happened, then clears the recorded events of this type
+		 * @param fn  Callable accepting const ComponentEvent&
+		 *
+		 * The callable should not add or remove components of the given type
+		 */
+		template<typename ComponentType, typename FunctionType>
+		void drainComponentEvents(FunctionType fn)
+		{
+			const ComponentTypeId typeId = ComponentType::GetTypeId();
+			for (const ComponentEvent& event : mComponentEvents.getEvents(typeId))
+			{
+				fn(event);
+			}
+			mComponentEvents.clearEvents(typeId);
+		}
+
+		template<typename ComponentType>
+		void clearComponentEvents()
+		{
+			mComponentEvents.clearEvents(ComponentType::GetTypeId());
+		}
+
+		void clearAllComponentEvents()
+		{
+			mComponentEvents.clearAllEvents();
+		}
+
+		/**
+		 * @brief Enables or disables recording of the last tick when components of the given type were written
+		 *
+		 * A component of a tracked type is considered changed when it is added, when it is marked with
+		 * markComponentChanged, or when it is accessed as non-const by forEachComponentSet, getComponents,
+		 * getEntityComponents and other queries. Request the type as const in queries that only read it.
+		 * Writes through pointers kept from earlier calls are not noticed, mark them with markComponentChanged.
+		 * Components that existed before tracking was enabled are considered unchanged
+		 */
+		template<typename ComponentType>
+		void trackComponentChanges(const bool isTracked = true)
+		{
+			setComponentChangesTracking(ComponentType::GetTypeId(), isTracked);
+		}
+
+		void setComponentChangesTracking(ComponentTypeId typeId, const bool isTracked)
+		{
+			mComponentChangeTicks.setTracking(typeId, isTracked);
+		}
+
+		/**
+		 * @brief Records that the component of the given type was written in the current tick
+		 *
+		 * Does nothing if the changes of the type are not tracked
+		 */
+		template<typename ComponentType>
+		void markComponentChanged(const Entity entity)
+		{
+			markComponentChanged(entity, ComponentType::GetTypeId());
+		}
+
+		void markComponentChanged(const Entity entity, ComponentTypeId typeId)
+		{
+			const Entity::RawId entityIdx = entity.getRawId();
+			if (!mEntitySlots.isAlive(entityIdx))
+			{
+				RACCOON_ECS_ERROR(std::string("Trying to mark component ") + toString(typeId) + " of a non-existent entity as changed " + std::to_string(entityIdx));
+				return;
+			}
+
+			mComponentChangeTicks.markChanged(typeId, entityIdx);
+		}
+
+		/**
+		 * @return the tick when the component of the given type was written last time,
+		 * 0 if it wasn't written since the tracking was enabled or the type is not tracked
+		 */
+		template<typename ComponentType>
+		[[nodiscard]] ChangeTick getComponentChangeTick(const Entity entity) const
+		{
+			const auto* ticks = mComponentChangeTicks.getTicks(ComponentType::GetTypeId());
+			return ticks ? ComponentChangeTicks::getTick(*ticks, entity.getRawId()) : 0;
+		}
+
+		/**
+		 * @return the tick that is recorded to the components changed at this moment
+		 */
+		[[nodiscard]] ChangeTick getCurrentChangeTick() const
+		{
+			return mComponentChangeTicks.getCurrentTick();
+		}
+
+		/**
+		 * @brief Starts a new change tick
+		 * @return the tick that was current before the call
+		 *
+		 * A system that processes changed components can store the returned value right after processing
+		 * and pass it as sinceTick next time, all the changes made after that will be visible to it
+		 */
+		ChangeTick advanceChangeTick()
+		{
+			return mComponentChangeTicks.advanceTick();
+		}
+
 		/**
 		 * @brief Creates a component of the given type and schedules its addition to the given entity
 		 * @param entity  The entity that will own the component
@@ -369,6 +648,27 @@ namespace RaccoonEcs
 			mScheduledComponentRemovals.emplace_back(entity, typeId);
 		}
 
+		/**
+		 * @brief Schedules enabling or disabling the component of the given type, see setComponentEnabled
+		 *
+		 * Safe to call while iterating over indexes, the change is applied in `executeScheduledActions`
+		 */
+		template<typename ComponentType>
+		void scheduleSetComponentEnabled(Entity entity, const bool isEnabled)
+		{
+			scheduleSetComponentEnabled(entity, ComponentType::GetTypeId(), isEnabled);
+		}
+
+		/**
+		 * @brief Schedules enabling or disabling the component of the given type, see setComponentEnabled
+		 *
+		 * Safe to call while iterating over indexes, the change is applied in `executeScheduledActions`
+		 */
+		void scheduleSetComponentEnabled(Entity entity, ComponentTypeId typeId, const bool isEnabled)
+		{
+			mScheduledEnabledStateChanges.emplace_back(entity, typeId, isEnabled);
+		}
+
 		/**
 		 * @brief Schedules removing the component of the given type from the given entity
 		 */
@@ -388,6 +688,12 @@ namespace RaccoonEcs
 			}
 			mScheduledComponentAdditions.clear();
 
+			for (const auto& change : mScheduledEnabledStateChanges)
+			{
+				setComponentEnabled(change.entity, change.typeId, change.isEnabled);
+			}
+			mScheduledEnabledStateChanges.clear();
+
 			for (const auto& removal : mScheduledComponentRemovals)
 			{
 				removeComponent(removal.entity, removal.typeId);
@@ -405,18 +711,44 @@ namespace RaccoonEcs
 		 * @brief Get specific component set belonging to the given entity
 		 * @return Returns the component set the the entity owns all the components,
 		 * otherwise can return components partially (part of them can be nullptr)
+		 *
+		 * Returned non-const components of tracked types are marked as changed, see trackComponentChanges
 		 */
 		template<typename... Components>
 		std::tuple<Components*...> getEntityComponents(const Entity entity)
 		{
 			const Entity::RawId entityIdx = entity.getRawId();
-			if (entityIdx >= mEntityExistanceFlags.size() || !mEntityExistanceFlags[entityIdx])
+			if (!mEntitySlots.isAlive(entityIdx))
 			{
 				return getEmptyComponents<Components...>();
 			}
 
-			auto componentVectors = mComponents.template getComponentVectors<Components...>();
-			return getEntityComponentSet<Components...>(entityIdx, componentVectors);
+#ifdef RACCOON_ECS_COPY_ON_WRITE_COMPONENTS
+			(makeComponentUnique<Components>(entityIdx), ...);
+#endif // RACCOON_ECS_COPY_ON_WRITE_COMPONENTS
+
+			const std::tuple<Components*...> components(mComponents.template getColumn<Components>().get(entityIdx)...);
+			if (mComponentChangeTicks.isAnyTracked())
+			{
+				markEntityComponentsChanged<Components...>(entityIdx, components);
+			}
+			return components;
+		}
+
+		/**
+		 * @brief Copies the components shared with other managers that a query of the given components
+		 * accesses as non-const, so the query itself doesn't need to touch the component pools
+		 *
+		 * Queries call it themselves, call it directly before running queries on managers that use
+		 * the same component factory in parallel, see CombinedEntityManagerView::forEachComponentSetParallel.
+		 * Does nothing without RACCOON_ECS_COPY_ON_WRITE_COMPONENTS
+		 */
+		template<typename... Components>
+		void makeQueriedComponentsUnique()
+		{
+#ifdef RACCOON_ECS_COPY_ON_WRITE_COMPONENTS
+			(makeQueriedComponentUnique<Components, Components...>(), ...);
+#endif // RACCOON_ECS_COPY_ON_WRITE_COMPONENTS
 		}
 
 		/**
@@ -430,10 +762,13 @@ namespace RaccoonEcs
 		template<typename... Components, typename... AdditionalData>
 		void getComponents(std::vector<std::tuple<AdditionalData..., Components*...>>& inOutComponents, AdditionalData... data)
 		{
-			const auto& components = mIndexes.template getComponents<Components...>(mComponents);
+			makeQueriedComponentsUnique<Components...>();
+			const auto components = mIndexes.template getComponents<Components...>(mComponents, mEntitySlots);
 
 			if (!components.empty())
 			{
+				markQueriedComponentsChanged<Components...>();
+
 				for (const auto& componentSet : components)
 				{
 					inOutComponents.push_back(std::tuple_cat(
@@ -455,26 +790,27 @@ namespace RaccoonEcs
 		template<typename... Components, typename... AdditionalData>
 		void getComponentsWithEntities(std::vector<std::tuple<AdditionalData..., Entity, Components*...>>& inOutComponents, AdditionalData... data)
 		{
-			const std::vector<size_t>& componentIndexes = mIndexes.template getIndex<Components...>(mComponents);
+			const std::span<const Entity> matchingEntities = mIndexes.template getIndex<Components...>(mComponents, mEntitySlots);
 
-			if (!componentIndexes.empty())
+			if (!matchingEntities.empty())
 			{
-				if (inOutComponents.size() + componentIndexes.size() > inOutComponents.capacity())
+				if (inOutComponents.size() + matchingEntities.size() > inOutComponents.capacity())
 				{
 					// have to use this weird syntax because it otherwise can break on MSVC is someone
 					// inludes <windows.h> before this file without NOMINMAX defined
-					const size_t newCapacity = (std::max)(inOutComponents.size() + componentIndexes.size(), inOutComponents.size() * 2);
+					const size_t newCapacity = (std::max)(inOutComponents.size() + matchingEntities.size(), inOutComponents.size() * 2);
 					inOutComponents.reserve(newCapacity);
 				}
 
-				auto components = mIndexes.template getComponents<Components...>(mComponents);
+				makeQueriedComponentsUnique<Components...>();
+				const auto components = mIndexes.template getComponents<Components...>(mComponents, mEntitySlots);
+				markQueriedComponentsChanged<Components...>(matchingEntities);
 
-				for (size_t i = 0; i < componentIndexes.size(); ++i)
+				for (size_t i = 0; i < matchingEntities.size(); ++i)
 				{
-					const size_t entityIdx = componentIndexes[i];
 					inOutComponents.push_back(std::tuple_cat(
 						std::make_tuple(data...),
-						std::make_tuple(Entity{ static_cast<Entity::RawId>(entityIdx), mEntityVersions[entityIdx] }),
+						std::make_tuple(matchingEntities[i]),
 						components[i]
 					));
 				}
@@ -490,10 +826,13 @@ namespace RaccoonEcs
 		template<typename... Components, typename FunctionType, typename... AdditionalData>
 		void forEachComponentSet(FunctionType processor, AdditionalData... data)
 		{
-			const auto& components = mIndexes.template getComponents<Components...>(mComponents);
+			makeQueriedComponentsUnique<Components...>();
+			const auto components = mIndexes.template getComponents<Components...>(mComponents, mEntitySlots);
 
 			if (!components.empty())
 			{
+				markQueriedComponentsChanged<Components...>();
+
 				for (const auto& componentSet : components)
 				{
 					std::apply(processor, std::tuple_cat(std::make_tuple(data...), componentSet));
@@ -511,20 +850,61 @@ namespace RaccoonEcs
 		template<typename... Components, typename FunctionType, typename... AdditionalData>
 		void forEachComponentSetWithEntity(FunctionType processor, AdditionalData... data)
 		{
-			const std::vector<size_t>& componentIndexes = mIndexes.template getIndex<Components...>(mComponents);
+			const std::span<const Entity> matchingEntities = mIndexes.template getIndex<Components...>(mComponents, mEntitySlots);
 
-			if (!componentIndexes.empty())
+			if (!matchingEntities.empty())
 			{
-				auto components = mIndexes.template getComponents<Components...>(mComponents);
+				makeQueriedComponentsUnique<Components...>();
+				const auto components = mIndexes.template getComponents<Components...>(mComponents, mEntitySlots);
+				markQueriedComponentsChanged<Components...>(matchingEntities);
 
-				for (size_t i = 0; i < componentIndexes.size(); ++i)
+				for (size_t i = 0; i < matchingEntities.size(); ++i)
 				{
-					const size_t entityIdx = componentIndexes[i];
-					std::apply(processor, std::tuple_cat(std::make_tuple(data...), std::make_tuple(Entity{ static_cast<Entity::RawId>(entityIdx), mEntityVersions[entityIdx] }), components[i]));
+					std::apply(processor, std::tuple_cat(std::make_tuple(data...), std::make_tuple(matchingEntities[i]), components[i]));
 				}
 			}
 		}
 
+		/**
+		 * @brief Applies the given callable to the component sets from matched entities that have
+		 * at least one of the given components changed after sinceTick
+		 * @param sinceTick  The tick after which the changes are taken into account, e.g. a value
+		 * previously returned by advanceChangeTick
+		 * @param processor  The callable that will be applied to the matched component sets
+		 * @param data  Additional data, will be added to each matched record. Can be useful
+		 * to identify a specific manager
+		 *
+		 * Only the components with tracked changes are checked, if none of the given components are
+		 * tracked nothing is matched. Non-const components of the processed sets are marked as changed
+		 */
+		template<typename... Components, typename FunctionType, typename... AdditionalData>
+		void forEachChangedComponentSet(const ChangeTick sinceTick, FunctionType processor, AdditionalData... data)
+		{
+			forEachChangedComponentSetInner<Components...>(sinceTick, [&processor, &data...](const Entity, const auto& componentSet) {
+				std::apply(processor, std::tuple_cat(std::make_tuple(data...), componentSet));
+			});
+		}
+
+		/**
+		 * @brief Applies the given callable to the entities together with component sets that have
+		 * at least one of the given components changed after sinceTick
+		 * @param sinceTick  The tick after which the changes are taken into account, e.g. a value
+		 * previously returned by advanceChangeTick
+		 * @param processor  The callable that will be applied to the matched component sets
+		 * @param data  Additional data, will be added to each matched record. Can be useful
+		 * to identify a specific manager
+		 *
+		 * Only the components with tracked changes are checked, if none of the given components are
+		 * tracked nothing is matched. Non-const components of the processed sets are marked as changed
+		 */
+		template<typename... Components, typename FunctionType, typename... AdditionalData>
+		void forEachChangedComponentSetWithEntity(const ChangeTick sinceTick, FunctionType processor, AdditionalData... data)
+		{
+			forEachChangedComponentSetInner<Components...>(sinceTick, [&processor, &data...](const Entity entity, const auto& componentSet) {
+				std::apply(processor, std::tuple_cat(std::make_tuple(data...), std::make_tuple(entity), componentSet));
+			});
+		}
+
 		/**
 		 * @brief Collects entities that have all of the given components and appends them to in-out argument
 		 * @param componentIndexes  Vector of types that need to be checked
@@ -541,9 +921,19 @@ namespace RaccoonEcs
 			// inludes <windows.h> before this file without NOMINMAX defined
 			size_t endIdx = (std::numeric_limits<Entity::RawId>::max)();
 			std::vector<const std::vector<void*>*> componentVectors;
+			std::vector<const typename ComponentMap::TagStorage*> tagStorages;
 			componentVectors.reserve(componentIndexes.size());
 			for (ComponentTypeId typeId : componentIndexes)
 			{
+				if (const auto* tagStorage = mComponents.getTagStorageById(typeId))
+				{
+					// have to use this weird syntax because it otherwise can break on MSVC if someone
+					// inludes <windows.h> before this file without NOMINMAX defined
+					endIdx = (std::min)(endIdx, tagStorage->flags.size());
+					tagStorages.push_back(tagStorage);
+					continue;
+				}
+
 				auto& componentVector = mComponents.getComponentVectorById(typeId);
 
 				// have to use this weird syntax because it otherwise can break on MSVC if someone
@@ -561,9 +951,15 @@ namespace RaccoonEcs
 					[idx](const std::vector<void*>* componentVector) { return (*componentVector)[idx] != nullptr; }
 				);
 
-				if (hasAllComponents)
+				const bool hasAllTags = std::all_of(
+					tagStorages.cbegin(),
+					tagStorages.cend(),
+					[idx](const typename ComponentMap::TagStorage* tagStorage) { return tagStorage->flags.test(idx); }
+				);
+
+				if (hasAllComponents && hasAllTags)
 				{
-					inOutEntities.push_back(Entity{ static_cast<Entity::RawId>(idx), mEntityVersions[idx] });
+					inOutEntities.push_back(mEntitySlots.makeEntity(idx));
 				}
 			}
 		}
@@ -577,39 +973,216 @@ namespace RaccoonEcs
 		template<typename... Components>
 		size_t getMatchingEntitiesCount()
 		{
-			return mIndexes.template getIndexSize<Components...>(mComponents);
+			return mIndexes.template getIndexSize<Components...>(mComponents, mEntitySlots);
 		}
 
 		/**
-		 * @brief Transfers the given entity together with its components to another manager
-		 * @param newManager  The manager to which the entity will be transfer to
-		 * @param entity  The entity that will be transferred
-		 * @return The entity in the new manager
+		 * @brief Computes a checksum of the alive entities and the components of the given types
+		 * @param componentTypes  Types of components to include, the order of the types affects the result
 		 *
-		 * The components are guaranteed not to be moved in the memory.
+		 * The result depends only on the entities, their components and the enabled state of the components,
+		 * but not on the addresses of the components or the order of the operations that led to this state.
+		 * So it can be compared between processes, e.g. to detect desyncs in lockstep simulations.
+		 * Components are hashed with the hash functions of the component factory
+		 *
+		 * @return the checksum, or nullopt if a non-tag type of the list has no hash function
+		 * (see ComponentFactory::setComponentHashFn), in all builds, so changes in its content can't go unnoticed
 		 */
-		Entity transferEntityTo(EntityManager& newManager, const Entity entity)
+		[[nodiscard]] std::optional<std::uint64_t> computeChecksum(const std::vector<ComponentTypeId>& componentTypes) const
 		{
-			if (this == &newManager)
+			if (!hasChecksumHashFns(componentTypes))
 			{
-				RACCOON_ECS_ERROR("Transferring entity to the same manager. This should never happen");
-				return entity;
+				return std::nullopt;
 			}
 
-			RACCOON_ECS_ASSERT(&mComponentFactory.get() == &newManager.mComponentFactory.get(), "Trying to transfer entity between managers with different component factories, this is not supported yet");
+			// entries are combined with a sum, so the order in which they are visited doesn't affect the result
+			std::uint64_t entriesHashSum = 0;
+			std::uint64_t entriesCount = 0;
 
-			const size_t oldEntityIdx = static_cast<size_t>(entity.getRawId());
-			if (oldEntityIdx >= mEntityExistanceFlags.size() || !mEntityExistanceFlags[oldEntityIdx])
+			mEntitySlots.forEachAlive([this, &entriesHashSum, &entriesCount](const size_t entityIdx) {
+				entriesHashSum += getChecksumEntryHash(0, entityIdx, mEntitySlots.getVersion(entityIdx), 0);
+				++entriesCount;
+			});
+
+			for (size_t typeOrder = 0; typeOrder < componentTypes.size(); ++typeOrder)
 			{
-				RACCOON_ECS_ERROR(std::string("Trying transfer non-existent entity: ") + std::to_string(entity.getRawId()));
-				return entity;
+				const ComponentTypeId typeId = componentTypes[typeOrder];
+				const bool isTag = mComponentFactory.get().isTagComponent(typeId);
+				const auto hashFn = isTag ? nullptr : mComponentFactory.get().getHashFn(typeId);
+				forEachChecksumComponent(typeId, [&, typeOrder](const size_t entityIdx, const void* component, const bool isDisabled) {
+					const std::uint64_t contentHash = hashFn ? hashFn(component) : 0;
+					entriesHashSum += getChecksumEntryHash(getChecksumSalt(typeOrder, isDisabled), entityIdx, mEntitySlots.getVersion(entityIdx), contentHash);
+					++entriesCount;
+				});
 			}
 
-			const Entity newEntity = newManager.addEntity();
+			return mixHash(entriesHashSum ^ mixHash(entriesCount));
+		}
 
-			for (auto& componentVector : mComponents)
+		/**
+		 * @brief Same as computeChecksum, but rehashes only the entries that changed since the previous call
+		 * with the same cache, the result is the same
+		 *
+		 * Keeps a running sum of the entries of each type, so unchanged components are only compared
+		 * with their cached state and are not hashed again.
+		 * Components modified without being marked as changed are not rehashed (see trackComponentChanges),
+		 * and the cache should be cleared when the manager is overridden or loaded from a snapshot
+		 *
+		 * Unlike the const overload, this one has side effects on the manager: it enables change tracking
+		 * of the given types, so from then on every non-const query of them marks change ticks,
+		 * and every call advances the change tick, the same counter that forEachChangedComponentSet uses
+		 *
+		 * @return the checksum, or nullopt if a non-tag type of the list has no hash function,
+		 * nothing is changed in the manager and the cache then
+		 */
+		[[nodiscard]] std::optional<std::uint64_t> computeChecksum(const std::vector<ComponentTypeId>& componentTypes, ComponentChecksumCache& cache)
+		{
+			if (!hasChecksumHashFns(componentTypes))
 			{
-				if (oldEntityIdx < componentVector.second.size())
+				return std::nullopt;
+			}
+
+			for (ComponentTypeId typeId : componentTypes)
+			{
+				if (mComponentChangeTicks.getTicks(typeId) == nullptr && !mComponentFactory.get().isTagComponent(typeId))
+				{
+					mComponentChangeTicks.setTracking(typeId, true);
+				}
+			}
+
+			const ChangeTick sinceTick = cache.getLastTick();
+
+			// entries of entities depend only on their versions, so they are recalculated without being stored
+			auto& entityEntries = cache.getEntityEntries();
+			std::vector<size_t> changedEntities;
+			// have to use this weird syntax because it otherwise can break on MSVC is someone
+			// inludes <windows.h> before this file without NOMINMAX defined
+			const size_t entitiesCount = (std::max)(entityEntries.versions.size(), mEntitySlots.size());
+			entityEntries.versions.resize(entitiesCount, 0);
+			entityEntries.isAlive.resize(entitiesCount, false);
+			for (size_t entityIdx = 0; entityIdx < entitiesCount; ++entityIdx)
+			{
+				const bool isAlive = mEntitySlots.isAlive(entityIdx);
+				const Entity::Version version = isAlive ? mEntitySlots.getVersion(entityIdx) : 0;
+				if (isAlive == entityEntries.isAlive[entityIdx] && version == entityEntries.versions[entityIdx])
+				{
+					continue;
+				}
+
+				if (entityEntries.isAlive[entityIdx])
+				{
+					entityEntries.hashSum -= getChecksumEntryHash(0, entityIdx, entityEntries.versions[entityIdx], 0);
+					--entityEntries.entriesCount;
+				}
+				if (isAlive)
+				{
+					entityEntries.hashSum += getChecksumEntryHash(0, entityIdx, version, 0);
+					++entityEntries.entriesCount;
+				}
+				entityEntries.isAlive[entityIdx] = isAlive;
+				entityEntries.versions[entityIdx] = version;
+				changedEntities.push_back(entityIdx);
+			}
+
+			std::uint64_t entriesHashSum = entityEntries.hashSum;
+			std::uint64_t entriesCount = entityEntries.entriesCount;
+			for (size_t typeOrder = 0; typeOrder < componentTypes.size(); ++typeOrder)
+			{
+				const ComponentTypeId typeId = componentTypes[typeOrder];
+				auto& componentEntries = cache.getComponentEntries(typeId);
+				if (componentEntries.salt != getChecksumSalt(typeOrder, false))
+				{
+					// the type was at another position in the list, so all its entries have other salts
+					componentEntries = {};
+					componentEntries.salt = getChecksumSalt(typeOrder, false);
+				}
+
+				const bool isTag = mComponentFactory.get().isTagComponent(typeId);
+				const auto hashFn = isTag ? nullptr : mComponentFactory.get().getHashFn(typeId);
+				const auto updateEntry = [&, typeOrder](const size_t entityIdx, const void* component, const bool isDisabled) {
+					const std::uint64_t contentHash = hashFn ? hashFn(component) : 0;
+					componentEntries.setEntry(entityIdx, getChecksumEntryHash(getChecksumSalt(typeOrder, isDisabled), entityIdx, mEntitySlots.getVersion(entityIdx), contentHash), component, isDisabled);
+				};
+
+				const typename ComponentChangeTicks::TicksVector* ticks = mComponentChangeTicks.getTicks(typeId);
+				std::uint64_t componentsCount = 0;
+				forEachChecksumComponent(typeId, [&, sinceTick](const size_t entityIdx, const void* component, const bool isDisabled) {
+					if (entityIdx >= componentEntries.size())
+					{
+						componentEntries.resize(entityIdx + 1);
+					}
+					++componentsCount;
+
+					const bool isChanged = ticks != nullptr && ComponentChangeTicks::getTick(*ticks, entityIdx) > sinceTick;
+					if (isChanged || componentEntries.entries[entityIdx].component != component || componentEntries.entries[entityIdx].wasDisabled != isDisabled)
+					{
+						updateEntry(entityIdx, component, isDisabled);
+					}
+				});
+
+				// all the existing components have entries now, so extra entries belong to removed components
+				if (componentEntries.entriesCount != componentsCount)
+				{
+					const std::vector<void*>& componentVector = mComponents.getComponentVectorById(typeId);
+					const auto* tagStorage = mComponents.getTagStorageById(typeId);
+					for (size_t entityIdx = 0; entityIdx < componentEntries.size(); ++entityIdx)
+					{
+						const bool hasComponent = (entityIdx < componentVector.size() && componentVector[entityIdx] != nullptr) || (tagStorage != nullptr && tagStorage->test(entityIdx));
+						if (!hasComponent)
+						{
+							componentEntries.removeEntry(entityIdx);
+						}
+					}
+				}
+
+				// entries include versions of their entities
+				for (const size_t entityIdx : changedEntities)
+				{
+					if (entityIdx < componentEntries.size() && componentEntries.entries[entityIdx].component != nullptr)
+					{
+						updateEntry(entityIdx, componentEntries.entries[entityIdx].component, componentEntries.entries[entityIdx].wasDisabled);
+					}
+				}
+
+				entriesHashSum += componentEntries.hashSum;
+				entriesCount += componentEntries.entriesCount;
+			}
+
+			// changes made after this call will have newer ticks
+			cache.setLastTick(advanceChangeTick());
+			return mixHash(entriesHashSum ^ mixHash(entriesCount));
+		}
+
+		/**
+		 * @brief Transfers the given entity together with its components to another manager
+		 * @param newManager  The manager to which the entity will be transfer to
+		 * @param entity  The entity that will be transferred
+		 * @return The entity in the new manager
+		 *
+		 * The components are guaranteed not to be moved in the memory.
+		 */
+		Entity transferEntityTo(EntityManager& newManager, const Entity entity)
+		{
+			if (this == &newManager)
+			{
+				RACCOON_ECS_ERROR("Transferring entity to the same manager. This should never happen");
+				return entity;
+			}
+
+			RACCOON_ECS_ASSERT(&mComponentFactory.get() == &newManager.mComponentFactory.get(), "Trying to transfer entity between managers with different component factories, this is not supported yet");
+
+			const size_t oldEntityIdx = static_cast<size_t>(entity.getRawId());
+			if (!mEntitySlots.isAlive(oldEntityIdx))
+			{
+				RACCOON_ECS_ERROR(std::string("Trying transfer non-existent entity: ") + std::to_string(entity.getRawId()));
+				return entity;
+			}
+
+			const Entity newEntity = newManager.addEntity();
+
+			for (auto& componentVector : mComponents)
+			{
+				if (oldEntityIdx < componentVector.second.size())
 				{
 					// transfer the component if it exists
 					if (componentVector.second[oldEntityIdx] != nullptr)
@@ -619,24 +1192,177 @@ namespace RaccoonEcs
 							componentVector.second[oldEntityIdx],
 							componentVector.first
 						);
+#ifdef RACCOON_ECS_COPY_ON_WRITE_COMPONENTS
+						onComponentMovedTo(newManager, componentVector.first);
+#endif // RACCOON_ECS_COPY_ON_WRITE_COMPONENTS
+
+						if (!mComponents.isComponentEnabled(componentVector.first, oldEntityIdx))
+						{
+							newManager.setComponentEnabled(newEntity, componentVector.first, false);
+						}
 
 						// remove the component from the old manager
 						componentVector.second[oldEntityIdx] = nullptr;
+						mComponentEvents.record(entity, componentVector.first, ComponentEventType::Removed);
+					}
+				}
+			}
+
+			for (auto& [typeId, tagStorage] : mComponents.getTagStorages())
+			{
+				if (tagStorage.test(oldEntityIdx))
+				{
+					newManager.addComponent(newEntity, tagStorage.instance, typeId);
+
+					if (!mComponents.isComponentEnabled(typeId, oldEntityIdx))
+					{
+						newManager.setComponentEnabled(newEntity, typeId, false);
 					}
+
+					tagStorage.flags.reset(oldEntityIdx);
+					mComponentEvents.record(entity, typeId, ComponentEventType::Removed);
 				}
 			}
 
 			mIndexes.onEntityRemoved(oldEntityIdx);
+			mComponents.resetEnabledState(oldEntityIdx);
+
+			mEntitySlots.release(static_cast<Entity::RawId>(oldEntityIdx));
+
+			return newEntity;
+		}
 
-			mEntityExistanceFlags[oldEntityIdx] = false;
-			const Entity::Version newVersion = ++mEntityVersions[oldEntityIdx];
-			// if we hit zero, we used up all the versions for this entity id, skip it
-			if (newVersion != 0)
+		/**
+		 * @brief Transfers the given entities together with their components to another manager
+		 * @param newManager  The manager to which the entities will be transferred to
+		 * @param entities  The entities that will be transferred
+		 * @return The entities in the new manager in the same order as the given entities,
+		 * invalid and repeated entities are not transferred and get not valid values
+		 *
+		 * Works like calling transferEntityTo for each entity, but moves the components type by type
+		 * and updates each index once for all the entities.
+		 * The components are guaranteed not to be moved in the memory.
+		 */
+		std::vector<OptionalEntity> transferEntitiesTo(EntityManager& newManager, std::span<const Entity> entities)
+		{
+			std::vector<OptionalEntity> newEntities(entities.size());
+
+			if (this == &newManager)
 			{
-				mFreeEntityIds.push_back(oldEntityIdx);
+				RACCOON_ECS_ERROR("Transferring entities to the same manager. This should never happen");
+				return newEntities;
 			}
 
-			return newEntity;
+			RACCOON_ECS_ASSERT(&mComponentFactory.get() == &newManager.mComponentFactory.get(), "Trying to transfer entities between managers with different component factories, this is not supported yet");
+
+			std::vector<Entity> oldTransferredEntities;
+			std::vector<Entity> newTransferredEntities;
+			oldTransferredEntities.reserve(entities.size());
+			newTransferredEntities.reserve(entities.size());
+			std::vector<bool> isEntityTransferred(mEntitySlots.size(), false);
+			for (size_t i = 0; i < entities.size(); ++i)
+			{
+				if (!mEntitySlots.isValid(entities[i]))
+				{
+					RACCOON_ECS_ERROR(std::string("Trying transfer non-existent entity: ") + std::to_string(entities[i].getRawId()));
+					continue;
+				}
+
+				if (isEntityTransferred[entities[i].getRawId()])
+				{
+					RACCOON_ECS_ERROR(std::string("Trying transfer the same entity twice: ") + std::to_string(entities[i].getRawId()));
+					continue;
+				}
+				isEntityTransferred[entities[i].getRawId()] = true;
+
+				const Entity newEntity = newManager.mEntitySlots.makeEntity(newManager.mEntitySlots.acquire());
+				newEntities[i] = newEntity;
+				oldTransferredEntities.push_back(entities[i]);
+				newTransferredEntities.push_back(newEntity);
+			}
+
+			if (oldTransferredEntities.empty())
+			{
+				return newEntities;
+			}
+
+			// the same order as in transferEntityTo, the entities are announced before they get their components
+			for (const Entity newEntity : newTransferredEntities)
+			{
+				newManager.onEntityAdded.broadcast(newEntity);
+			}
+
+			const size_t newEntitiesEndIdx = static_cast<size_t>(std::ranges::max(newTransferredEntities, {}, &Entity::getRawId).getRawId()) + 1;
+			const size_t transferredCount = oldTransferredEntities.size();
+
+			for (auto& [typeId, componentVector] : mComponents)
+			{
+				std::vector<void*>* newComponentVector = nullptr;
+				for (size_t i = 0; i < transferredCount; ++i)
+				{
+					const size_t oldEntityIdx = static_cast<size_t>(oldTransferredEntities[i].getRawId());
+					if (oldEntityIdx >= componentVector.size() || componentVector[oldEntityIdx] == nullptr)
+					{
+						continue;
+					}
+
+					if (newComponentVector == nullptr)
+					{
+						newComponentVector = &newManager.mComponents.getOrCreateComponentVectorById(typeId);
+						if (newComponentVector->size() < newEntitiesEndIdx)
+						{
+							newComponentVector->resize(newEntitiesEndIdx);
+						}
+					}
+
+					const size_t newEntityIdx = static_cast<size_t>(newTransferredEntities[i].getRawId());
+					(*newComponentVector)[newEntityIdx] = componentVector[oldEntityIdx];
+					componentVector[oldEntityIdx] = nullptr;
+#ifdef RACCOON_ECS_COPY_ON_WRITE_COMPONENTS
+					onComponentMovedTo(newManager, typeId);
+#endif // RACCOON_ECS_COPY_ON_WRITE_COMPONENTS
+					onComponentTransferred(newManager, typeId, oldTransferredEntities[i], newTransferredEntities[i]);
+				}
+			}
+
+			for (auto& [typeId, tagStorage] : mComponents.getTagStorages())
+			{
+				typename ComponentMap::TagStorage* newTagStorage = nullptr;
+				for (size_t i = 0; i < transferredCount; ++i)
+				{
+					const size_t oldEntityIdx = static_cast<size_t>(oldTransferredEntities[i].getRawId());
+					if (!tagStorage.test(oldEntityIdx))
+					{
+						continue;
+					}
+
+					if (newTagStorage == nullptr)
+					{
+						newTagStorage = &newManager.mComponents.getOrCreateTagStorageById(typeId);
+						newTagStorage->instance = tagStorage.instance;
+						if (newTagStorage->flags.size() < newEntitiesEndIdx)
+						{
+							newTagStorage->flags.resize(newEntitiesEndIdx);
+						}
+					}
+
+					newTagStorage->flags.set(newTransferredEntities[i].getRawId());
+					tagStorage.flags.reset(oldEntityIdx);
+					onComponentTransferred(newManager, typeId, oldTransferredEntities[i], newTransferredEntities[i]);
+				}
+			}
+
+			// all the components are in place, so each index is checked once per entity
+			newManager.mIndexes.onEntitiesAdded(newTransferredEntities, newManager.mComponents);
+			mIndexes.onEntitiesRemoved(oldTransferredEntities);
+
+			for (const Entity entity : oldTransferredEntities)
+			{
+				mComponents.resetEnabledState(entity.getRawId());
+				mEntitySlots.release(entity.getRawId());
+			}
+
+			return newEntities;
 		}
 
 		/**
@@ -649,7 +1375,7 @@ namespace RaccoonEcs
 		template<typename... Components>
 		void initIndex()
 		{
-			mIndexes.template initializeIndex<Components...>(mComponents);
+			mIndexes.template initializeIndex<Components...>(mComponents, mEntitySlots);
 		}
 
 #ifdef RACCOON_ECS_COPYABLE_COMPONENTS
@@ -659,10 +1385,47 @@ namespace RaccoonEcs
 		void overrideBy(const EntityManager& originalInstance)
 		{
 			clear();
-			copyEntitiesFrom(originalInstance);
+			copyEntitiesFrom(originalInstance, AllComponentTypes{});
+		}
+
+		/**
+		 * @brief Rewrite this entity manager with a copy of originalInstance that has only components of the given types
+		 * @param componentTypes  Types of components that will be copied, e.g. only the simulation state
+		 *
+		 * All the entities are copied, even if they don't have any of the given components
+		 */
+		void overrideBy(const EntityManager& originalInstance, const std::vector<ComponentTypeId>& componentTypes)
+		{
+			clear();
+			copyEntitiesFrom(originalInstance, ListedComponentTypes{ componentTypes });
 		}
 #endif // RACCOON_ECS_COPYABLE_COMPONENTS
 
+#ifdef RACCOON_ECS_COPY_ON_WRITE_COMPONENTS
+		/**
+		 * @brief Rewrite this entity manager with a copy of originalInstance that shares components with it
+		 *
+		 * A shared component is copied only when one of the managers accesses it as non-const,
+		 * so making the copy costs about the same as copying the component vectors.
+		 * Request components as const in queries that only read them to avoid the copies
+		 */
+		void overrideBySharing(const EntityManager& originalInstance)
+		{
+			clear();
+			shareEntitiesFrom(originalInstance, AllComponentTypes{});
+		}
+
+		/**
+		 * @brief Rewrite this entity manager with a copy of originalInstance that has only components
+		 * of the given types, the components are shared with originalInstance
+		 */
+		void overrideBySharing(const EntityManager& originalInstance, const std::vector<ComponentTypeId>& componentTypes)
+		{
+			clear();
+			shareEntitiesFrom(originalInstance, ListedComponentTypes{ componentTypes });
+		}
+#endif // RACCOON_ECS_COPY_ON_WRITE_COMPONENTS
+
 		/**
 		 * @brief Shrinks the vectors of components to eliminate empty elements at the end, and
 		 * remove empty vectors
@@ -685,14 +1448,160 @@ namespace RaccoonEcs
 				}
 			}
 
+			for (auto& [typeId, tagStorage] : mComponents.getTagStorages())
+			{
+				tagStorage.flags.shrinkToLastSetBit();
+			}
+
 			mComponents.cleanEmptyVectors();
 		}
 
+		/**
+		 * @brief Moves alive entities to the lowest ids and shrinks the storages indexed by entity ids,
+		 * e.g. after a mass removal of entities
+		 * @param remapCallback  Called as remapCallback(Entity oldEntity, Entity newEntity) for every moved entity
+		 * @return amount of moved entities
+		 *
+		 * Entities keep their relative order, entities that are already in place keep their handles.
+		 * Moved entities get new ids and versions, so their handles that are stored outside of the manager
+		 * should be updated from the callback, the old handles become invalid.
+		 * Indexes and recorded component events are updated, data captured by RewindBufferImpl is not.
+		 * Should not be called while there are scheduled actions, see executeScheduledActions
+		 */
+		template<typename RemapCallback>
+		size_t compactEntityIds(RemapCallback&& remapCallback)
+		{
+			if (!mScheduledComponentAdditions.empty() || !mScheduledEnabledStateChanges.empty() || !mScheduledComponentRemovals.empty() || !mScheduledEntityRemovals.empty())
+			{
+				RACCOON_ECS_ERROR("Entity ids can't be compacted while there are scheduled actions, call executeScheduledActions first");
+				return 0;
+			}
+
+			// versions of the old handles by old ids, to recognize them after the slots are changed
+			std::vector<Entity::Version> oldVersions(mEntitySlots.size());
+			mEntitySlots.forEachAlive([this, &oldVersions](const size_t entityIdx) {
+				oldVersions[entityIdx] = mEntitySlots.getVersion(entityIdx);
+			});
+
+			// retired ids are skipped, so the new ids are not always dense
+			const std::vector<Entity::RawId> oldIdxByNewIdx = mEntitySlots.compactAlive();
+			std::vector<Entity::RawId> newIdxByOldIdx(oldVersions.size(), EntitySlots::Slot::NoNextSlot);
+			for (size_t newIdx = 0; newIdx < oldIdxByNewIdx.size(); ++newIdx)
+			{
+				if (oldIdxByNewIdx[newIdx] != EntitySlots::Slot::NoNextSlot)
+				{
+					newIdxByOldIdx[oldIdxByNewIdx[newIdx]] = static_cast<Entity::RawId>(newIdx);
+				}
+			}
+
+			mComponents.compactEntities(oldIdxByNewIdx);
+			mComponentChangeTicks.compactEntities(oldIdxByNewIdx);
+			mIndexes.remapEntities(newIdxByOldIdx, mEntitySlots);
+			mComponentEvents.remapEntities([this, &oldVersions, &newIdxByOldIdx](const Entity entity) {
+				const size_t entityIdx = static_cast<size_t>(entity.getRawId());
+				if (entityIdx < newIdxByOldIdx.size() && newIdxByOldIdx[entityIdx] != EntitySlots::Slot::NoNextSlot && oldVersions[entityIdx] == entity.getVersion())
+				{
+					return mEntitySlots.makeEntity(newIdxByOldIdx[entityIdx]);
+				}
+				// removed entities keep their handles, they can't match the new entities
+				return entity;
+			});
+
+			size_t movedEntitiesCount = 0;
+			for (size_t newIdx = 0; newIdx < oldIdxByNewIdx.size(); ++newIdx)
+			{
+				const Entity::RawId oldIdx = oldIdxByNewIdx[newIdx];
+				if (oldIdx != EntitySlots::Slot::NoNextSlot && oldIdx != newIdx)
+				{
+					remapCallback(Entity(oldIdx, oldVersions[oldIdx]), mEntitySlots.makeEntity(newIdx));
+					++movedEntitiesCount;
+				}
+			}
+			return movedEntitiesCount;
+		}
+
+		/**
+		 * @brief Moves components to new memory in the order of entity indexes, so iterating over components
+		 * and indexes reads the memory in the order of addresses, e.g. after free slots were reused for a long time
+		 * @param maxVisitedComponents  Limit of component slots visited by this call, allows to split a pass over several frames
+		 * @return true when the pass is finished, the next call starts a new pass
+		 *
+		 * Trivially copyable components are copied bytewise, others are move-constructed.
+		 * Types with already contiguous components are skipped, chunks emptied by a pass are released with ComponentPool::trim.
+		 * Components shared with copy-on-write copies are not moved.
+		 * Pointers to components obtained before the call become invalid, entity handles stay valid.
+		 * Entities and components can be added and removed between the calls of one pass
+		 */
+		bool defragmentComponents(const size_t maxVisitedComponents = MaxOfSizeType)
+		{
+			if (!mDefragmentation.isInProgress)
+			{
+				mDefragmentation.componentTypes.clear();
+				for (const auto& [typeId, componentVector] : mComponents)
+				{
+					mDefragmentation.componentTypes.push_back(typeId);
+				}
+				mDefragmentation.typeIdx = 0;
+				mDefragmentation.entityIdx = 0;
+				mDefragmentation.isInProgress = true;
+			}
+
+			size_t visitedComponentsCount = 0;
+			for (; mDefragmentation.typeIdx < mDefragmentation.componentTypes.size(); ++mDefragmentation.typeIdx, mDefragmentation.entityIdx = 0)
+			{
+				const ComponentTypeId typeId = mDefragmentation.componentTypes[mDefragmentation.typeIdx];
+				ComponentPoolBase* pool = mComponentFactory.get().getComponentPool(typeId);
+				std::vector<void*>& componentVector = mComponents.getComponentVectorById(typeId);
+				if (mDefragmentation.entityIdx == 0)
+				{
+					if (pool == nullptr || pool->areComponentsContiguous(componentVector))
+					{
+						continue;
+					}
+					// reserve only if this call can start moving the type, otherwise the next call would reserve the slots again
+					if (visitedComponentsCount == maxVisitedComponents)
+					{
+						return false;
+					}
+					mDefragmentation.relocationSlots = pool->reserveRelocationSlots(componentVector.size() - static_cast<size_t>(std::count(componentVector.begin(), componentVector.end(), nullptr)));
+				}
+
+				for (; mDefragmentation.entityIdx < componentVector.size(); ++mDefragmentation.entityIdx)
+				{
+					if (visitedComponentsCount == maxVisitedComponents)
+					{
+						return false;
+					}
+					++visitedComponentsCount;
+
+					void*& component = componentVector[mDefragmentation.entityIdx];
+					if (component != nullptr)
+					{
+						void* relocatedComponent = pool->relocateComponent(mDefragmentation.relocationSlots, component);
+						if (relocatedComponent != component)
+						{
+							component = relocatedComponent;
+							mIndexes.onComponentRelocated(typeId, mDefragmentation.entityIdx, component);
+						}
+					}
+				}
+
+				pool->finishRelocation(mDefragmentation.relocationSlots);
+				pool->trim();
+			}
+
+			mIndexes.sortEntriesByEntities();
+			mDefragmentation.isInProgress = false;
+			return true;
+		}
+
 		/**
 		 * @brief Delete all entities and components stored in the manager
 		 */
 		void clear()
 		{
+			cancelDefragmentation();
+
 			for (auto& componentVector : mComponents)
 			{
 				auto deleterFn = mComponentFactory.get().getDeletionFn(componentVector.first);
@@ -703,28 +1612,43 @@ namespace RaccoonEcs
 				}
 				componentVector.second.clear();
 			}
+			mComponents.getTagStorages().clear();
 			mComponents.cleanEmptyVectors();
+			mComponents.clearEnabledState();
 
-			mEntityExistanceFlags.clear();
-			mEntityVersions.clear();
-			mFreeEntityIds.clear();
+			mEntitySlots.clear();
 
 			mScheduledComponentAdditions.clear();
+			mScheduledEnabledStateChanges.clear();
 			mScheduledComponentRemovals.clear();
 
 			mIndexes.clear();
+			mComponentEvents.clearAllEvents();
+			mComponentChangeTicks.clearTicks();
+#ifdef RACCOON_ECS_COPY_ON_WRITE_COMPONENTS
+			mSharedComponentCounts.clear();
+#endif // RACCOON_ECS_COPY_ON_WRITE_COMPONENTS
 		}
 
 		/**
 		 * @brief Get const component data
 		 *
-		 * Can be useful for serialization
+		 * Can be useful for serialization.
+		 * Note that tag components are stored separately and can be accessed with getTagStorages
 		 */
 		const ComponentMap& getComponentsData() const { return mComponents; }
 
 	public:
-		MulticastDelegate<> onEntityAdded;
-		MulticastDelegate<> onEntityRemoved;
+		MulticastDelegate<Entity> onEntityAdded;
+		MulticastDelegate<Entity> onEntityRemoved;
+
+	private:
+		// restores entity slots of the world, that are not exposed otherwise
+		friend class RewindBufferImpl<ComponentTypeId, ComponentFactory>;
+		// writes and bulk-loads the whole state of the world
+		friend class SnapshotSerializerImpl<ComponentTypeId, ComponentFactory>;
+		// compares and patches entity slots and component vectors of worlds directly
+		friend class WorldDiffImpl<ComponentTypeId, ComponentFactory>;
 
 	private:
 		struct ComponentToAdd
@@ -751,6 +1675,30 @@ namespace RaccoonEcs
 			{}
 		};
 
+		struct ComponentEnabledStateChange
+		{
+			Entity entity;
+			ComponentTypeId typeId;
+			bool isEnabled;
+
+			ComponentEnabledStateChange(const Entity entity, ComponentTypeId typeId, const bool isEnabled)
+				: entity(entity)
+				, typeId(typeId)
+				, isEnabled(isEnabled)
+			{}
+		};
+
+		// position of an unfinished pass of defragmentComponents
+		struct DefragmentationState
+		{
+			std::vector<ComponentTypeId> componentTypes;
+			size_t typeIdx = 0;
+			size_t entityIdx = 0;
+			// slots of the current type reserved by this manager, the pool can be shared with other managers
+			ComponentPoolBase::RelocationSlots relocationSlots;
+			bool isInProgress = false;
+		};
+
 	private:
 		template<int I = 0>
 		static std::tuple<> getEmptyComponents()
@@ -764,55 +1712,245 @@ namespace RaccoonEcs
 			return std::tuple_cat(std::tuple<FirstComponent*>(nullptr), getEmptyComponents<Components...>());
 		}
 
-		template<unsigned Index, typename Datas>
-		static std::tuple<> getEntityComponentSetInner(size_t /*entityIdx*/, Datas& /*componentVectors*/)
+		template<typename... ComponentVector>
+		static size_t GetShortestVector(const std::tuple<ComponentVector&...>& vectorTuple)
 		{
-			return {};
+			// have to use this weird syntax because it otherwise can break on MSVC is someone
+			// inludes <windows.h> before this file without NOMINMAX defined
+			size_t minimalSize = (std::numeric_limits<size_t>::max)();
+			std::apply(
+				[&minimalSize](const ComponentVector&... componentVector) {
+					// have to use this weird syntax because it otherwise can break on MSVC is someone
+					// inludes <windows.h> before this file without NOMINMAX defined
+					((minimalSize = (std::min)(minimalSize, componentVector.size())), ...);
+				},
+				vectorTuple
+			);
+			return minimalSize;
+		}
+
+		/**
+		 * @return tick storages of the non-const tracked components, nullptr for the other components
+		 */
+		template<typename... Components>
+		std::array<typename ComponentChangeTicks::TicksVector*, sizeof...(Components)> getWrittenComponentTicks()
+		{
+			return { (std::is_const_v<Components> ? nullptr : mComponentChangeTicks.getTicks(Components::GetTypeId()))... };
 		}
 
-		template<unsigned Index, typename Datas, typename FirstComponent, typename... Components>
-		std::tuple<FirstComponent*, Components*...> getEntityComponentSetInner(size_t entityIdx, Datas& componentVectors)
+		template<typename... Components>
+		void markQueriedComponentsChanged(std::span<const Entity> matchingEntities)
 		{
-			if (std::get<Index>(componentVectors).size() <= entityIdx)
+			if (!mComponentChangeTicks.isAnyTracked())
 			{
-				return getEmptyComponents<FirstComponent, Components...>();
+				return;
 			}
 
-			auto& component = std::get<Index>(componentVectors)[entityIdx];
-			if (component == nullptr)
+			for (auto* ticks : getWrittenComponentTicks<Components...>())
 			{
-				return getEmptyComponents<FirstComponent, Components...>();
+				if (ticks != nullptr)
+				{
+					for (const Entity entity : matchingEntities)
+					{
+						mComponentChangeTicks.markChanged(*ticks, entity.getRawId());
+					}
+				}
 			}
+		}
+
+		template<typename... Components>
+		void markEntityComponentsChanged(const size_t entityIdx, const std::tuple<Components*...>& components)
+		{
+			const auto writtenTicks = getWrittenComponentTicks<Components...>();
+			const std::array<bool, sizeof...(Components)> hasComponents = std::apply(
+				[](const auto*... component) {
+					return std::array<bool, sizeof...(Components)>{ (component != nullptr)... };
+				},
+				components
+			);
 
-			return std::tuple_cat(std::make_tuple(static_cast<FirstComponent*>(component)), getEntityComponentSetInner<Index + 1, Datas, Components...>(entityIdx, componentVectors));
+			for (size_t i = 0; i < sizeof...(Components); ++i)
+			{
+				if (writtenTicks[i] != nullptr && hasComponents[i])
+				{
+					mComponentChangeTicks.markChanged(*writtenTicks[i], entityIdx);
+				}
+			}
 		}
 
-		template<typename FirstComponent, typename... Components, typename... Data>
-		std::tuple<FirstComponent*, Components*...> getEntityComponentSet(const size_t entityIdx, std::tuple<std::vector<Data*>&...>& componentVectors)
+		void cancelDefragmentation()
 		{
-			using Datas = std::tuple<std::vector<Data*>&...>;
-			return getEntityComponentSetInner<0, Datas, FirstComponent, Components...>(entityIdx, componentVectors);
+			if (mDefragmentation.isInProgress)
+			{
+				// the state of a moved-from manager has no types
+				if (mDefragmentation.typeIdx < mDefragmentation.componentTypes.size())
+				{
+					if (ComponentPoolBase* pool = mComponentFactory.get().getComponentPool(mDefragmentation.componentTypes[mDefragmentation.typeIdx]))
+					{
+						pool->finishRelocation(mDefragmentation.relocationSlots);
+					}
+				}
+				mDefragmentation.isInProgress = false;
+			}
 		}
 
-		template<typename... ComponentVector>
-		static size_t GetShortestVector(const std::tuple<ComponentVector&...>& vectorTuple)
+#ifdef RACCOON_ECS_COPY_ON_WRITE_COMPONENTS
+		template<typename Component, typename... Components>
+		void makeQueriedComponentUnique()
 		{
-			// have to use this weird syntax because it otherwise can break on MSVC is someone
-			// inludes <windows.h> before this file without NOMINMAX defined
-			size_t minimalSize = (std::numeric_limits<size_t>::max)();
-			std::apply(
-				[&minimalSize](const ComponentVector&... componentVector) {
-					// have to use this weird syntax because it otherwise can break on MSVC is someone
-					// inludes <windows.h> before this file without NOMINMAX defined
-					((minimalSize = (std::min)(minimalSize, componentVector.size())), ...);
-				},
-				vectorTuple
-			);
-			return minimalSize;
+			if constexpr (!std::is_const_v<Component> && !std::is_empty_v<Component>)
+			{
+				ComponentPool<Component>* pool = mComponentFactory.get().template getComponentPool<Component>();
+				if (!mayHaveSharedComponents(Component::GetTypeId(), pool))
+				{
+					return;
+				}
+
+				std::vector<void*>& componentVector = mComponents.getComponentVectorById(Component::GetTypeId());
+				for (const Entity entity : mIndexes.template getIndex<Components...>(mComponents, mEntitySlots))
+				{
+					void*& component = componentVector[entity.getRawId()];
+					if (ComponentPool<Component>::isComponentShared(component))
+					{
+						component = pool->makeComponentUnique(component);
+						mIndexes.onComponentRelocated(Component::GetTypeId(), entity.getRawId(), component);
+						onComponentMadeUnique(Component::GetTypeId());
+					}
+				}
+			}
+		}
+#endif // RACCOON_ECS_COPY_ON_WRITE_COMPONENTS
+
+		template<typename... Components>
+		void markQueriedComponentsChanged()
+		{
+			if (mComponentChangeTicks.isAnyTracked())
+			{
+				markQueriedComponentsChanged<Components...>(mIndexes.template getIndex<Components...>(mComponents, mEntitySlots));
+			}
+		}
+
+		template<typename... Components, typename FunctionType>
+		void forEachChangedComponentSetInner(const ChangeTick sinceTick, FunctionType&& fn)
+		{
+			const std::array<const typename ComponentChangeTicks::TicksVector*, sizeof...(Components)> readTicks{
+				mComponentChangeTicks.getTicks(Components::GetTypeId())...
+			};
+
+			if (std::ranges::all_of(readTicks, [](const auto* ticks) { return ticks == nullptr; }))
+			{
+				return;
+			}
+
+			const std::span<const Entity> matchingEntities = mIndexes.template getIndex<Components...>(mComponents, mEntitySlots);
+			if (matchingEntities.empty())
+			{
+				return;
+			}
+
+			const auto components = mIndexes.template getComponents<Components...>(mComponents, mEntitySlots);
+			const auto writtenTicks = getWrittenComponentTicks<Components...>();
+
+			for (size_t i = 0; i < matchingEntities.size(); ++i)
+			{
+				const size_t entityIdx = static_cast<size_t>(matchingEntities[i].getRawId());
+				const bool isChanged = std::ranges::any_of(readTicks, [entityIdx, sinceTick](const auto* ticks) {
+					return ticks != nullptr && ComponentChangeTicks::getTick(*ticks, entityIdx) > sinceTick;
+				});
+
+				if (isChanged)
+				{
+					for (auto* ticks : writtenTicks)
+					{
+						if (ticks != nullptr)
+						{
+							mComponentChangeTicks.markChanged(*ticks, entityIdx);
+						}
+					}
+#ifdef RACCOON_ECS_COPY_ON_WRITE_COMPONENTS
+					(makeComponentUnique<Components>(entityIdx), ...);
+#endif // RACCOON_ECS_COPY_ON_WRITE_COMPONENTS
+					fn(matchingEntities[i], components[i]);
+				}
+			}
+		}
+
+		/**
+		 * @brief Calls fn(entityIdx, component, isDisabled) for each component of the type, including tags
+		 */
+		template<typename FunctionType>
+		void forEachChecksumComponent(ComponentTypeId typeId, FunctionType&& fn) const
+		{
+			const DynamicBitset* disabledFlags = mComponents.getDisabledFlags(typeId);
+			const auto isDisabled = [disabledFlags](const size_t entityIdx) {
+				return disabledFlags != nullptr && entityIdx < disabledFlags->size() && disabledFlags->test(entityIdx);
+			};
+
+			if (const auto* tagStorage = mComponents.getTagStorageById(typeId))
+			{
+				tagStorage->flags.forEachSetBit([&fn, &isDisabled, tagStorage](const size_t entityIdx) {
+					fn(entityIdx, static_cast<const void*>(tagStorage->instance), isDisabled(entityIdx));
+				});
+				return;
+			}
+
+			const std::vector<void*>& componentVector = mComponents.getComponentVectorById(typeId);
+			for (size_t entityIdx = 0; entityIdx < componentVector.size(); ++entityIdx)
+			{
+				if (componentVector[entityIdx] != nullptr)
+				{
+					fn(entityIdx, static_cast<const void*>(componentVector[entityIdx]), isDisabled(entityIdx));
+				}
+			}
+		}
+
+		[[nodiscard]] static std::uint64_t getChecksumSalt(const size_t typeOrder, const bool isDisabled)
+		{
+			return mixHash(static_cast<std::uint64_t>(typeOrder) * 2 + (isDisabled ? 2 : 1));
+		}
+
+		[[nodiscard]] static std::uint64_t getChecksumEntryHash(const std::uint64_t salt, const size_t entityIdx, const Entity::Version version, const std::uint64_t contentHash)
+		{
+			const std::uint64_t entityKey = (static_cast<std::uint64_t>(entityIdx) << 32) | version;
+			return mixHash(salt ^ mixHash(entityKey ^ mixHash(contentHash)));
+		}
+
+		[[nodiscard]] bool hasChecksumHashFns(const std::vector<ComponentTypeId>& componentTypes) const
+		{
+			for (ComponentTypeId typeId : componentTypes)
+			{
+				if (!mComponentFactory.get().isTagComponent(typeId) && !mComponentFactory.get().getHashFn(typeId))
+				{
+					RACCOON_ECS_ERROR(std::string("Component type has no hash function, the checksum can't include its content: ") + toString(typeId));
+					return false;
+				}
+			}
+			return true;
+		}
+
+		/**
+		 * @brief Updates the state of both managers after a component was moved, except indexes
+		 */
+		void onComponentTransferred(EntityManager& newManager, ComponentTypeId typeId, const Entity oldEntity, const Entity newEntity)
+		{
+			if (!mComponents.isComponentEnabled(typeId, oldEntity.getRawId()))
+			{
+				newManager.mComponents.setComponentEnabled(typeId, newEntity.getRawId(), false);
+			}
+
+			mComponentEvents.record(oldEntity, typeId, ComponentEventType::Removed);
+			newManager.mComponentEvents.record(newEntity, typeId, ComponentEventType::Added);
+			newManager.mComponentChangeTicks.markChanged(typeId, newEntity.getRawId());
 		}
 
 		void addComponentToEntity(size_t entityIdx, void* component, ComponentTypeId typeId)
 		{
+			if (mComponentFactory.get().isTagComponent(typeId))
+			{
+				addTagToEntity(entityIdx, component, typeId);
+				return;
+			}
+
 			auto& componentsVector = mComponents.getOrCreateComponentVectorById(typeId);
 			if (componentsVector.size() <= entityIdx)
 			{
@@ -823,37 +1961,195 @@ namespace RaccoonEcs
 				componentsVector.resize(entityIdx + 1);
 			}
 
+			const Entity entity = mEntitySlots.makeEntity(entityIdx);
 			if (componentsVector[entityIdx] == nullptr)
 			{
 				componentsVector[entityIdx] = component;
+				mComponentEvents.record(entity, typeId, ComponentEventType::Added);
+				mComponentChangeTicks.markChanged(typeId, entityIdx);
 			}
 			else
 			{
 				RACCOON_ECS_ERROR(std::string("Trying to add a component when the entity already has one of the same type. This will result in UB, entity: ") + std::to_string(entityIdx) + ", component: " + toString(typeId));
 			}
-			mIndexes.onComponentAdded(typeId, entityIdx, mComponents);
+			mIndexes.onComponentAdded(typeId, entity, mComponents);
+		}
+
+		void addTagToEntity(size_t entityIdx, void* component, ComponentTypeId typeId)
+		{
+			auto& tagStorage = mComponents.getOrCreateTagStorageById(typeId);
+			tagStorage.instance = component;
+			if (tagStorage.flags.size() <= entityIdx)
+			{
+				tagStorage.flags.resize(entityIdx + 1);
+			}
+
+			if (tagStorage.flags.test(entityIdx))
+			{
+				RACCOON_ECS_ERROR(std::string("Trying to add a tag component when the entity already has one of the same type, entity: ") + std::to_string(entityIdx) + ", component: " + toString(typeId));
+				return;
+			}
+
+			const Entity entity = mEntitySlots.makeEntity(entityIdx);
+			tagStorage.flags.set(entityIdx);
+			mComponentEvents.record(entity, typeId, ComponentEventType::Added);
+			mComponentChangeTicks.markChanged(typeId, entityIdx);
+			mIndexes.onComponentAdded(typeId, entity, mComponents);
 		}
 
 #ifdef RACCOON_ECS_COPYABLE_COMPONENTS
-		void copyEntitiesFrom(const EntityManager& originalInstance)
+		struct AllComponentTypes
+		{
+			bool operator()(ComponentTypeId) const noexcept { return true; }
+		};
+
+		struct ListedComponentTypes
 		{
-			mEntityExistanceFlags = originalInstance.mEntityExistanceFlags;
-			mEntityVersions = originalInstance.mEntityVersions;
-			mFreeEntityIds = originalInstance.mFreeEntityIds;
+			const std::vector<ComponentTypeId>& componentTypes;
 
+			bool operator()(ComponentTypeId typeId) const
+			{
+				return std::find(componentTypes.begin(), componentTypes.end(), typeId) != componentTypes.end();
+			}
+		};
+
+		template<typename ComponentTypeFilter>
+		void copyEntitiesFrom(const EntityManager& originalInstance, const ComponentTypeFilter& shouldCopyType)
+		{
 			for (auto& componentVectorPair : originalInstance.mComponents)
 			{
+				if (!shouldCopyType(componentVectorPair.first))
+				{
+					continue;
+				}
+
+				std::vector<void*>& newComponents = mComponents.getOrCreateComponentVectorById(componentVectorPair.first);
+				// one call per type, so the pool can reserve memory once and copy trivial types bytewise
+				mComponentFactory.get().getCloneComponentsFn(componentVectorPair.first)(componentVectorPair.second, newComponents);
+			}
+			copyEntitiesStateFrom(originalInstance, shouldCopyType);
+		}
+
+#ifdef RACCOON_ECS_COPY_ON_WRITE_COMPONENTS
+		template<typename ComponentTypeFilter>
+		void shareEntitiesFrom(const EntityManager& originalInstance, const ComponentTypeFilter& shouldCopyType)
+		{
+			for (auto& componentVectorPair : originalInstance.mComponents)
+			{
+				if (!shouldCopyType(componentVectorPair.first))
+				{
+					continue;
+				}
+
 				std::vector<void*>& newComponents = mComponents.getOrCreateComponentVectorById(componentVectorPair.first);
-				const std::vector<void*>& originalComponents = componentVectorPair.second;
-				const size_t componentsCount = originalComponents.size();
-				newComponents.resize(componentsCount);
-				const auto cloneFn = mComponentFactory.get().getCloneFn(componentVectorPair.first);
-				for (size_t i = 0; i < componentsCount; ++i)
+				newComponents = componentVectorPair.second;
+				mComponentFactory.get().getComponentPool(componentVectorPair.first)->shareComponents(newComponents);
+
+				// both managers now own every shared component
+				const size_t sharedCount = static_cast<size_t>(std::ranges::count_if(newComponents, [](const void* component) { return component != nullptr; }));
+				if (sharedCount > 0)
+				{
+					mSharedComponentCounts[componentVectorPair.first] += sharedCount;
+					originalInstance.mSharedComponentCounts[componentVectorPair.first] += sharedCount;
+				}
+			}
+			copyEntitiesStateFrom(originalInstance, shouldCopyType);
+		}
+
+		template<typename Component>
+		void makeComponentUnique(const size_t entityIdx)
+		{
+			if constexpr (!std::is_const_v<Component> && !std::is_empty_v<Component>)
+			{
+				ComponentPool<Component>* pool = mComponentFactory.get().template getComponentPool<Component>();
+				if (!mayHaveSharedComponents(Component::GetTypeId(), pool))
 				{
-					newComponents[i] = cloneFn(originalComponents[i]);
+					return;
 				}
+
+				std::vector<void*>& componentVector = mComponents.getComponentVectorById(Component::GetTypeId());
+				if (entityIdx < componentVector.size() && componentVector[entityIdx] != nullptr && ComponentPool<Component>::isComponentShared(componentVector[entityIdx]))
+				{
+					componentVector[entityIdx] = pool->makeComponentUnique(componentVector[entityIdx]);
+					mIndexes.onComponentRelocated(Component::GetTypeId(), entityIdx, componentVector[entityIdx]);
+					onComponentMadeUnique(Component::GetTypeId());
+				}
+			}
+		}
+
+		void makeComponentUnique(ComponentTypeId typeId, const size_t entityIdx, void*& component)
+		{
+			ComponentPoolBase* pool = mComponentFactory.get().getComponentPool(typeId);
+			if (!mayHaveSharedComponents(typeId, pool))
+			{
+				return;
+			}
+
+			void* uniqueComponent = pool->makeComponentUnique(component);
+			if (uniqueComponent != component)
+			{
+				component = uniqueComponent;
+				mIndexes.onComponentRelocated(typeId, entityIdx, component);
+				onComponentMadeUnique(typeId);
 			}
 		}
+
+		/**
+		 * @return false if none of the components of the type that this manager owns are shared with other managers
+		 */
+		[[nodiscard]] bool mayHaveSharedComponents(ComponentTypeId typeId, const ComponentPoolBase* pool)
+		{
+			const auto it = mSharedComponentCounts.find(typeId);
+			if (it == mSharedComponentCounts.end())
+			{
+				return false;
+			}
+
+			if (pool == nullptr || !pool->hasSharedComponents())
+			{
+				// the other owners released or copied all the shared components
+				mSharedComponentCounts.erase(it);
+				return false;
+			}
+			return true;
+		}
+
+		void onComponentMadeUnique(ComponentTypeId typeId)
+		{
+			const auto it = mSharedComponentCounts.find(typeId);
+			if (it != mSharedComponentCounts.end() && --it->second == 0)
+			{
+				mSharedComponentCounts.erase(it);
+			}
+		}
+
+		/**
+		 * @brief Keeps a moved component counted as possibly shared in the new manager
+		 */
+		void onComponentMovedTo(EntityManager& newManager, ComponentTypeId typeId) const
+		{
+			if (mSharedComponentCounts.contains(typeId))
+			{
+				++newManager.mSharedComponentCounts[typeId];
+			}
+		}
+#endif // RACCOON_ECS_COPY_ON_WRITE_COMPONENTS
+
+		template<typename ComponentTypeFilter>
+		void copyEntitiesStateFrom(const EntityManager& originalInstance, const ComponentTypeFilter& shouldCopyType)
+		{
+			mEntitySlots = originalInstance.mEntitySlots;
+			for (const auto& [typeId, tagStorage] : originalInstance.mComponents.getTagStorages())
+			{
+				if (shouldCopyType(typeId))
+				{
+					mComponents.getOrCreateTagStorageById(typeId) = tagStorage;
+				}
+			}
+			mComponents.copyEnabledStateFrom(originalInstance.mComponents, shouldCopyType);
+			mComponentChangeTicks = originalInstance.mComponentChangeTicks;
+			mIndexes.copyFrom(originalInstance.mIndexes, mComponents, shouldCopyType);
+		}
 #endif // RACCOON_ECS_COPYABLE_COMPONENTS
 
 	private:
@@ -861,14 +2157,26 @@ namespace RaccoonEcs
 
 		ComponentIndexes<ComponentTypeId> mIndexes;
 
-		std::vector<bool> mEntityExistanceFlags;
-		std::vector<Entity::Version> mEntityVersions;
-		std::vector<size_t> mFreeEntityIds;
+		ComponentEventsImpl<ComponentTypeId> mComponentEvents;
+
+		ComponentChangeTicks mComponentChangeTicks;
+
+		EntitySlots mEntitySlots;
 
 		std::vector<ComponentToAdd> mScheduledComponentAdditions;
+		std::vector<ComponentEnabledStateChange> mScheduledEnabledStateChanges;
 		std::vector<ComponentToRemove> mScheduledComponentRemovals;
 		std::vector<Entity> mScheduledEntityRemovals;
 
+		DefragmentationState mDefragmentation;
+
+#ifdef RACCOON_ECS_COPY_ON_WRITE_COMPONENTS
+		// upper bound of the amount of components of each type that are shared with other managers,
+		// non-const access skips looking for shared components of types that are not listed here.
+		// mutable because sharing components from a manager makes its own components shared too
+		mutable std::unordered_map<ComponentTypeId, size_t> mSharedComponentCounts;
+#endif // RACCOON_ECS_COPY_ON_WRITE_COMPONENTS
+
 		std::reference_wrapper<const ComponentFactory> mComponentFactory;
 	};
 
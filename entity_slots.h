@@ -0,0 +1,349 @@
+#pragma once
+
+#include <cstdint>
+#include <limits>
+#include <span>
+#include <vector>
+
+#include "dynamic_bitset.h"
+#include "entity.h"
+#include "error_handling.h"
+
+namespace RaccoonEcs
+{
+	/**
+	 * @brief Storage of entity ids of one manager
+	 *
+	 * Each id has a slot that keeps its current version together with the link to the next free slot,
+	 * so validating an entity touches only one slot. Free slots form an intrusive LIFO list.
+	 * Additionally keeps a packed bitset of alive ids that is used to enumerate entities fast.
+	 *
+	 * Optionally a non-zero tag can be assigned to the slots, then the upper bits of entity versions
+	 * store the tag, so the owner of an entity can be found without checking all the owners.
+	 */
+	class EntitySlots
+	{
+	public:
+		using Tag = std::uint8_t;
+		constexpr static size_t TagShift = sizeof(Entity::Version) * 8 - sizeof(Tag) * 8;
+
+	public:
+		struct Slot
+		{
+			// have to use this weird syntax because it otherwise can break on MSVC is someone
+			// inludes <windows.h> before this file without NOMINMAX defined
+			constexpr static Entity::RawId AliveMarker = (std::numeric_limits<Entity::RawId>::max)();
+			constexpr static Entity::RawId NoNextSlot = AliveMarker - 1;
+
+			Entity::Version version = 0;
+			// AliveMarker for alive entities, otherwise the next free slot in the free list
+			Entity::RawId nextFreeSlot = AliveMarker;
+
+			[[nodiscard]] bool isAlive() const noexcept { return nextFreeSlot == AliveMarker; }
+		};
+
+	public:
+		/**
+		 * @brief Takes a free slot or creates a new one and marks it alive
+		 * @return raw id of the taken slot
+		 */
+		Entity::RawId acquire()
+		{
+			Entity::RawId rawId;
+			if (mFirstFreeSlot == Slot::NoNextSlot)
+			{
+				RACCOON_ECS_ASSERT(mSlots.size() < Slot::NoNextSlot, "Ran out of entity ids");
+				rawId = static_cast<Entity::RawId>(mSlots.size());
+				mSlots.emplace_back();
+				mAliveSlots.pushBack(true);
+			}
+			else
+			{
+				rawId = mFirstFreeSlot;
+				Slot& slot = mSlots[rawId];
+				mFirstFreeSlot = slot.nextFreeSlot;
+				slot.nextFreeSlot = Slot::AliveMarker;
+				mAliveSlots.set(rawId);
+			}
+			return rawId;
+		}
+
+		/**
+		 * @brief Marks the slot as free and increases its version, the slot should be alive
+		 */
+		void release(const Entity::RawId rawId)
+		{
+			Slot& slot = mSlots[rawId];
+			RACCOON_ECS_ASSERT(slot.isAlive(), "Releasing an entity slot that is not alive");
+			mAliveSlots.reset(rawId);
+			slot.version = (slot.version + 1) & mVersionMask;
+			// if we hit zero, we used up all the versions for this entity id, skip it
+			if (slot.version != 0)
+			{
+				slot.nextFreeSlot = mFirstFreeSlot;
+				mFirstFreeSlot = rawId;
+			}
+			else
+			{
+				slot.nextFreeSlot = Slot::NoNextSlot;
+			}
+		}
+
+		/**
+		 * @return true if the id is alive, regardless of the version
+		 */
+		[[nodiscard]] bool isAlive(const size_t rawId) const noexcept
+		{
+			return rawId < mSlots.size() && mSlots[rawId].isAlive();
+		}
+
+		/**
+		 * @return true if the entity is alive and has the same version
+		 */
+		[[nodiscard]] bool isValid(const Entity entity) const noexcept
+		{
+			const size_t rawId = static_cast<size_t>(entity.getRawId());
+			if (rawId >= mSlots.size())
+			{
+				return false;
+			}
+			const Slot& slot = mSlots[rawId];
+			return (slot.version | mTagBits) == entity.getVersion() && slot.isAlive();
+		}
+
+		[[nodiscard]] Entity::Version getVersion(const size_t rawId) const noexcept
+		{
+			return mSlots[rawId].version | mTagBits;
+		}
+
+		[[nodiscard]] Entity makeEntity(const size_t rawId) const noexcept
+		{
+			return Entity{ static_cast<Entity::RawId>(rawId), mSlots[rawId].version | mTagBits };
+		}
+
+		/**
+		 * @brief Sets the tag that will be stored in versions of the entities, can be set only before any entity is created
+		 *
+		 * With a non-zero tag versions wrap around faster, so ids are retired more often
+		 */
+		void setTag(const Tag tag)
+		{
+			RACCOON_ECS_ASSERT(mSlots.empty(), "Entity tag can be changed only before any entity is created");
+			mTagBits = static_cast<Entity::Version>(tag) << TagShift;
+			// have to use this weird syntax because it otherwise can break on MSVC is someone
+			// inludes <windows.h> before this file without NOMINMAX defined
+			mVersionMask = (tag == 0) ? (std::numeric_limits<Entity::Version>::max)() : (static_cast<Entity::Version>(1) << TagShift) - 1;
+		}
+
+		[[nodiscard]] Tag getTag() const noexcept { return static_cast<Tag>(mTagBits >> TagShift); }
+
+		/**
+		 * @return the tag of the slots that created the entity, meaningful only if the slots had a non-zero tag
+		 */
+		[[nodiscard]] static Tag GetEntityTag(const Entity entity) noexcept
+		{
+			return static_cast<Tag>(entity.getVersion() >> TagShift);
+		}
+
+		/**
+		 * @return amount of slots, both alive and free
+		 */
+		[[nodiscard]] size_t size() const noexcept { return mSlots.size(); }
+
+		[[nodiscard]] bool hasAnyAlive() const noexcept { return mAliveSlots.any(); }
+
+		[[nodiscard]] size_t getAliveCount() const noexcept { return mAliveSlots.count(); }
+
+		/**
+		 * @brief Calls the given function with the raw id of each alive slot in ascending order
+		 */
+		template<typename FunctionType>
+		void forEachAlive(FunctionType&& fn) const
+		{
+			mAliveSlots.forEachSetBit(std::forward<FunctionType>(fn));
+		}
+
+		[[nodiscard]] const Slot& getSlot(const size_t rawId) const noexcept
+		{
+			return mSlots[rawId];
+		}
+
+		[[nodiscard]] Entity::RawId getFirstFreeSlot() const noexcept { return mFirstFreeSlot; }
+
+		/**
+		 * @brief Overwrites the state of the slot with a previously saved one, adds slots if needed
+		 *
+		 * Used to restore earlier states, the caller is responsible for keeping the free list consistent
+		 */
+		void restoreSlot(const size_t rawId, const Slot slot)
+		{
+			if (rawId >= mSlots.size())
+			{
+				mSlots.resize(rawId + 1, Slot{ 0, Slot::NoNextSlot });
+				mAliveSlots.resize(rawId + 1);
+			}
+			mSlots[rawId] = slot;
+			mAliveSlots.assign(rawId, slot.isAlive());
+		}
+
+		[[nodiscard]] std::span<const Slot> getSlots() const noexcept { return mSlots; }
+
+		/**
+		 * @brief Replaces all the slots with previously saved ones and rebuilds the set of alive slots
+		 */
+		void assignSlots(std::vector<Slot>&& slots, const Entity::RawId firstFreeSlot)
+		{
+			mSlots = std::move(slots);
+			mAliveSlots.clear();
+			mAliveSlots.resize(mSlots.size());
+			for (size_t rawId = 0; rawId < mSlots.size(); ++rawId)
+			{
+				if (mSlots[rawId].isAlive())
+				{
+					mAliveSlots.set(rawId);
+				}
+			}
+			mFirstFreeSlot = firstFreeSlot;
+		}
+
+		/**
+		 * @return true if the free list starting from firstFreeSlot goes only through slots that are not alive,
+		 * has no cycles and contains all such slots except the retired ones, e.g. to check slots from untrusted data
+		 */
+		[[nodiscard]] static bool IsFreeListValid(std::span<const Slot> slots, const Entity::RawId firstFreeSlot)
+		{
+			DynamicBitset freeListSlots;
+			freeListSlots.resize(slots.size());
+			for (Entity::RawId rawId = firstFreeSlot; rawId != Slot::NoNextSlot; rawId = slots[rawId].nextFreeSlot)
+			{
+				if (rawId >= slots.size() || slots[rawId].isAlive() || freeListSlots.test(rawId))
+				{
+					return false;
+				}
+				freeListSlots.set(rawId);
+			}
+
+			for (size_t rawId = 0; rawId < slots.size(); ++rawId)
+			{
+				// retired slots are the only ones that are neither alive nor in the free list
+				if (!slots[rawId].isAlive() && !freeListSlots.test(rawId) && slots[rawId].nextFreeSlot != Slot::NoNextSlot)
+				{
+					return false;
+				}
+			}
+			return true;
+		}
+
+		/**
+		 * @brief Restores previously saved amount of slots and the head of the free list
+		 */
+		void restoreFreeList(const size_t slotsCount, const Entity::RawId firstFreeSlot)
+		{
+			mSlots.resize(slotsCount, Slot{ 0, Slot::NoNextSlot });
+			mAliveSlots.resize(slotsCount);
+			mFirstFreeSlot = firstFreeSlot;
+		}
+
+		/**
+		 * @brief Moves the alive slots to the lowest ids keeping their order, moved slots get new versions
+		 * @return old raw id for every new raw id up to the last alive one, Slot::NoNextSlot for the retired slots
+		 * that were skipped
+		 *
+		 * Works as if the moved entities were released and acquired at the new ids, so the old handles
+		 * stay invalid. Retired slots are never reused, and a slot whose version would wrap to zero
+		 * when reused is retired instead. The freed slots keep their versions and are reused starting from the lowest id.
+		 */
+		std::vector<Entity::RawId> compactAlive()
+		{
+			// retired slots are not in the free list and should stay out of it
+			DynamicBitset freeListSlots;
+			freeListSlots.resize(mSlots.size());
+			for (Entity::RawId rawId = mFirstFreeSlot; rawId != Slot::NoNextSlot; rawId = mSlots[rawId].nextFreeSlot)
+			{
+				freeListSlots.set(rawId);
+			}
+
+			// destination slots are always below their sources, and each of them is written once,
+			// so they still have their initial state when written
+			std::vector<Entity::RawId> oldIdxByNewIdx;
+			oldIdxByNewIdx.reserve(mAliveSlots.count());
+			mAliveSlots.forEachSetBit([this, &freeListSlots, &oldIdxByNewIdx](const size_t oldRawId) {
+				while (oldIdxByNewIdx.size() != oldRawId)
+				{
+					Slot& newSlot = mSlots[oldIdxByNewIdx.size()];
+					if (newSlot.isAlive())
+					{
+						// the entity of this slot was moved to a lower id
+						newSlot.version = (newSlot.version + 1) & mVersionMask;
+						if (newSlot.version != 0)
+						{
+							newSlot.nextFreeSlot = Slot::AliveMarker;
+							break;
+						}
+						newSlot.nextFreeSlot = Slot::NoNextSlot;
+					}
+					else if (freeListSlots.test(oldIdxByNewIdx.size()))
+					{
+						newSlot.nextFreeSlot = Slot::AliveMarker;
+						break;
+					}
+					oldIdxByNewIdx.push_back(Slot::NoNextSlot);
+				}
+				oldIdxByNewIdx.push_back(static_cast<Entity::RawId>(oldRawId));
+			});
+
+			mFirstFreeSlot = Slot::NoNextSlot;
+			for (size_t rawId = mSlots.size(); rawId > oldIdxByNewIdx.size();)
+			{
+				--rawId;
+				Slot& slot = mSlots[rawId];
+				bool isFree = freeListSlots.test(rawId);
+				if (slot.isAlive())
+				{
+					// the entity was moved to a lower id
+					slot.version = (slot.version + 1) & mVersionMask;
+					isFree = slot.version != 0;
+				}
+
+				if (isFree)
+				{
+					slot.nextFreeSlot = mFirstFreeSlot;
+					mFirstFreeSlot = static_cast<Entity::RawId>(rawId);
+				}
+				else
+				{
+					slot.nextFreeSlot = Slot::NoNextSlot;
+				}
+			}
+
+			mAliveSlots.clear();
+			mAliveSlots.resize(mSlots.size());
+			for (size_t newRawId = 0; newRawId < oldIdxByNewIdx.size(); ++newRawId)
+			{
+				if (oldIdxByNewIdx[newRawId] != Slot::NoNextSlot)
+				{
+					mAliveSlots.set(newRawId);
+				}
+			}
+			return oldIdxByNewIdx;
+		}
+
+		void clear() noexcept
+		{
+			mSlots.clear();
+			mAliveSlots.clear();
+			mFirstFreeSlot = Slot::NoNextSlot;
+		}
+
+	private:
+		std::vector<Slot> mSlots;
+		DynamicBitset mAliveSlots;
+		Entity::RawId mFirstFreeSlot = Slot::NoNextSlot;
+		Entity::Version mTagBits = 0;
+		// have to use this weird syntax because it otherwise can break on MSVC is someone
+		// inludes <windows.h> before this file without NOMINMAX defined
+		Entity::Version mVersionMask = (std::numeric_limits<Entity::Version>::max)();
+	};
+
+	static_assert(sizeof(EntitySlots::Slot) == 8, "Size of entity slot changed, make sure this is intentional");
+} // namespace RaccoonEcs
@@ -0,0 +1,192 @@
+#pragma once
+
+#ifdef RACCOON_ECS_COPYABLE_COMPONENTS
+
+#include <atomic>
+#include <cstddef>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <string>
+#include <system_error>
+#include <thread>
+#include <vector>
+
+#include "../entity_manager.h"
+#include "../error_handling.h"
+#include "snapshot_serializer.h"
+
+namespace RaccoonEcs
+{
+	/**
+	 * @brief Saves snapshots of a world to disk on a background thread while the world keeps changing
+	 *
+	 * Starting a save copies the world on the calling thread, with RACCOON_ECS_COPY_ON_WRITE_COMPONENTS
+	 * the copy shares the components with the world, otherwise the components are cloned in bulk.
+	 * Then the copy is serialized, processed and written to disk on a background thread.
+	 * Since component pools are not thread-safe, the copy is destroyed only on the thread that
+	 * owns the world, in collectFinishedSave or waitForSave.
+	 *
+	 * With RACCOON_ECS_COPY_ON_WRITE_COMPONENTS the world shares its components with the copy until the save
+	 * is collected, and writing a shared component copies it from the pool. So until then, the world should
+	 * not be accessed as non-const from several threads at once. Parallel queries of
+	 * CombinedEntityManagerView copy the queried components before starting their tasks, but their
+	 * processors should not access other components of the world as non-const.
+	 *
+	 * Component types should not be registered while a save is in progress,
+	 * and errors of the background thread are reported from that thread.
+	 */
+	template<typename ComponentTypeId, typename ComponentFactory = ComponentFactoryImpl<ComponentTypeId>>
+	class AsyncSnapshotWriterImpl
+	{
+	public:
+		using EntityManager = EntityManagerImpl<ComponentTypeId, ComponentFactory>;
+		using SnapshotSerializer = SnapshotSerializerImpl<ComponentTypeId, ComponentFactory>;
+		// transforms the serialized data before it is written, e.g. compresses it, returns false on failure
+		using ProcessDataFn = std::function<bool(std::vector<std::byte>& inOutData)>;
+
+	public:
+		/**
+		 * @param componentFactory  Factory of the worlds that will be saved
+		 * @param serializer  Serializer with all the saved types registered, should outlive the writer
+		 */
+		AsyncSnapshotWriterImpl(const ComponentFactory& componentFactory, const SnapshotSerializer& serializer)
+			: mWorldCopy(componentFactory)
+			, mSerializer(serializer)
+		{
+		}
+
+		~AsyncSnapshotWriterImpl()
+		{
+			waitForSave();
+		}
+
+		AsyncSnapshotWriterImpl(const AsyncSnapshotWriterImpl&) = delete;
+		AsyncSnapshotWriterImpl& operator=(const AsyncSnapshotWriterImpl&) = delete;
+		AsyncSnapshotWriterImpl(AsyncSnapshotWriterImpl&&) = delete;
+		AsyncSnapshotWriterImpl& operator=(AsyncSnapshotWriterImpl&&) = delete;
+
+		/**
+		 * @brief Captures the current state of the world and starts writing it to the file in the background
+		 * @param path  The file is replaced only after the whole snapshot is written
+		 * @param processDataFn  Optional processing of the serialized data, called on the background thread
+		 * @return false if the previous save is not collected yet
+		 */
+		bool startSave(const EntityManager& world, const std::string& path, ProcessDataFn&& processDataFn = nullptr)
+		{
+			if (mWorkerThread.joinable())
+			{
+				RACCOON_ECS_ERROR("Trying to start saving a snapshot before the previous save was collected");
+				return false;
+			}
+
+#ifdef RACCOON_ECS_COPY_ON_WRITE_COMPONENTS
+			mWorldCopy.overrideBySharing(world);
+#else
+			mWorldCopy.overrideBy(world);
+#endif // RACCOON_ECS_COPY_ON_WRITE_COMPONENTS
+
+			mIsFinished.store(false, std::memory_order_relaxed);
+			mWorkerThread = std::thread([this, path, processDataFn = std::move(processDataFn)]() {
+				mIsSuccessful = writeSnapshot(path, processDataFn);
+				mIsFinished.store(true, std::memory_order_release);
+			});
+			return true;
+		}
+
+		[[nodiscard]] bool isSaveInProgress() const
+		{
+			return mWorkerThread.joinable() && !mIsFinished.load(std::memory_order_acquire);
+		}
+
+		/**
+		 * @brief Releases the captured copy of the world if its save has finished, doesn't block
+		 * @param outIsSuccessful  Receives the result of the finished save
+		 * @return true if a save was finished by this call
+		 *
+		 * Should be called from the thread that owns the world, e.g. once per tick
+		 */
+		bool collectFinishedSave(bool& outIsSuccessful)
+		{
+			if (!mWorkerThread.joinable() || !mIsFinished.load(std::memory_order_acquire))
+			{
+				return false;
+			}
+
+			outIsSuccessful = finishSave();
+			return true;
+		}
+
+		/**
+		 * @brief Blocks until the current save is finished and releases the captured copy of the world
+		 * @return result of the save, true if there was no save in progress
+		 */
+		bool waitForSave()
+		{
+			if (!mWorkerThread.joinable())
+			{
+				return true;
+			}
+
+			return finishSave();
+		}
+
+	private:
+		bool finishSave()
+		{
+			mWorkerThread.join();
+			mWorldCopy.clear();
+			return mIsSuccessful;
+		}
+
+		bool writeSnapshot(const std::string& path, const ProcessDataFn& processDataFn)
+		{
+			mSerializedData.clear();
+			if (!mSerializer.save(mWorldCopy, mSerializedData))
+			{
+				return false;
+			}
+
+			if (processDataFn && !processDataFn(mSerializedData))
+			{
+				RACCOON_ECS_ERROR("Processing of the serialized snapshot failed, the snapshot is not saved: " + path);
+				return false;
+			}
+
+			// write to a temporary file first, so a crash during the save doesn't corrupt the previous snapshot
+			const std::string temporaryPath = path + ".tmp";
+			{
+				std::ofstream file(temporaryPath, std::ios::binary | std::ios::trunc);
+				file.write(reinterpret_cast<const char*>(mSerializedData.data()), static_cast<std::streamsize>(mSerializedData.size()));
+				file.close();
+				if (!file)
+				{
+					RACCOON_ECS_ERROR("Can't write snapshot file: " + temporaryPath);
+					return false;
+				}
+			}
+
+			std::error_code errorCode;
+			std::filesystem::rename(temporaryPath, path, errorCode);
+			if (errorCode)
+			{
+				RACCOON_ECS_ERROR("Can't replace snapshot file: " + path);
+				return false;
+			}
+			return true;
+		}
+
+	private:
+		EntityManager mWorldCopy;
+		const SnapshotSerializer& mSerializer;
+
+		std::thread mWorkerThread;
+		std::atomic<bool> mIsFinished = false;
+		// written by the worker before mIsFinished is set
+		bool mIsSuccessful = false;
+		// kept between the saves to avoid reallocations
+		std::vector<std::byte> mSerializedData;
+	};
+} // namespace RaccoonEcs
+
+#endif // RACCOON_ECS_COPYABLE_COMPONENTS
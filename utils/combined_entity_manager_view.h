@@ -1,8 +1,13 @@
 #pragma once
 
+#include <algorithm>
+#include <array>
+#include <functional>
+#include <limits>
 #include <span>
 #include <vector>
 
+#include "../entity_slots.h"
 #include "../msvc_fix.h"
 #include "entity_view.h"
 
@@ -28,16 +33,19 @@ namespace RaccoonEcs
 		explicit CombinedEntityManagerView(std::span<Record> entityManagers)
 			: mRecords(entityManagers.begin(), entityManagers.end())
 		{
+			fillRecordsByTag();
 		}
 
 		explicit CombinedEntityManagerView(const std::vector<Record>& entityManagers)
 			: mRecords(entityManagers)
 		{
+			fillRecordsByTag();
 		}
 
 		explicit CombinedEntityManagerView(std::vector<Record>&& entityManagers)
 			: mRecords(std::move(entityManagers))
 		{
+			fillRecordsByTag();
 		}
 
 		explicit CombinedEntityManagerView(const std::vector<EntityManagerRef>& entityManagers)
@@ -47,6 +55,7 @@ namespace RaccoonEcs
 			{
 				mRecords.push_back({ entityManager, nullptr });
 			}
+			fillRecordsByTag();
 		}
 
 		CombinedEntityManagerView(const CombinedEntityManagerView&) = default;
@@ -127,6 +136,60 @@ namespace RaccoonEcs
 			}
 		}
 
+		/**
+		 * @brief Parallel versions of forEachComponentSet* functions, each manager is processed by only one task
+		 * @param executor  Callable that accepts std::vector<std::function<void()>>& with tasks, runs all of them
+		 * (possibly in parallel) and returns only after all the tasks are finished
+		 * @param maxTasksCount  Maximal amount of tasks to create, e.g. the amount of worker threads
+		 * @param processor  Called concurrently from different tasks, so it should be thread-safe
+		 *
+		 * The managers are distributed between the tasks based on their getMatchingEntitiesCount.
+		 * The processor should not add or remove entities or components, since the managers share component pools.
+		 * For the same reason, the queried components that are shared with other managers (see
+		 * EntityManagerImpl::overrideBySharing, AsyncSnapshotWriterImpl) are copied before the tasks start,
+		 * and the processor should not access other shared components as non-const, e.g. with EntityView::getComponents.
+		 */
+		template<typename... Components, typename Executor, typename FunctionType>
+		void forEachComponentSetParallel(Executor&& executor, const size_t maxTasksCount, FunctionType processor)
+		{
+			executeDistributedTasks<Components...>(executor, maxTasksCount, [&processor](Record& record) {
+				record.entityManager.get().TEMPLATE_MSVC_FIX forEachComponentSet<Components...>(processor);
+			});
+		}
+
+		template<typename... Components, typename Executor, typename FunctionType>
+		void forEachComponentSetWithEntityParallel(Executor&& executor, const size_t maxTasksCount, FunctionType processor)
+		{
+			executeDistributedTasks<Components...>(executor, maxTasksCount, [&processor](Record& record) {
+				record.entityManager.get().TEMPLATE_MSVC_FIX forEachComponentSetWithEntity<Components...>(
+					[&processor, &entityManager = record.entityManager.get()](Entity entity, Components*... components) mutable -> void {
+						processor(EntityView{ entity, entityManager }, components...);
+					}
+				);
+			});
+		}
+
+		template<typename... Components, typename Executor, typename FunctionType>
+		void forEachComponentSetWithExtraDataParallel(Executor&& executor, const size_t maxTasksCount, FunctionType processor)
+		{
+			executeDistributedTasks<Components...>(executor, maxTasksCount, [&processor](Record& record) {
+				record.entityManager.get().TEMPLATE_MSVC_FIX forEachComponentSet<Components...>(processor, record.extraData);
+			});
+		}
+
+		template<typename... Components, typename Executor, typename FunctionType>
+		void forEachComponentSetWithEntityAndExtraDataParallel(Executor&& executor, const size_t maxTasksCount, FunctionType processor)
+		{
+			executeDistributedTasks<Components...>(executor, maxTasksCount, [&processor](Record& record) {
+				record.entityManager.get().TEMPLATE_MSVC_FIX forEachComponentSetWithEntity<Components...>(
+					[&processor, &entityManager = record.entityManager.get()](ExtraData data, Entity entity, Components*... components) mutable -> void {
+						processor(data, EntityView{ entity, entityManager }, components...);
+					},
+					record.extraData
+				);
+			});
+		}
+
 		template<typename... Components>
 		size_t getMatchingEntitiesCount()
 		{
@@ -149,19 +212,126 @@ namespace RaccoonEcs
 		template<typename TypedComponent>
 		void getAllEntityComponents(Entity entity, std::vector<TypedComponent>& outComponents)
 		{
+			if (EntityManager* entityManager = findEntityManager(entity))
+			{
+				entityManager->TEMPLATE_MSVC_EMSCRIPTEN_FIX getAllEntityComponents(entity, outComponents);
+			}
+		}
+
+		/**
+		 * @return the manager that has the given entity, or nullptr if none of them have it
+		 *
+		 * Takes O(1) if all the managers have different non-zero entity tags
+		 * (see EntityManagerImpl::setEntityTag), otherwise checks the managers one by one
+		 */
+		EntityManager* findEntityManager(const Entity entity)
+		{
+			if (mAreTagsUnique)
+			{
+				const size_t recordIdx = mRecordIdxByTag[EntitySlots::GetEntityTag(entity)];
+				if (recordIdx != NoRecord && mRecords[recordIdx].entityManager.get().hasEntity(entity))
+				{
+					return &mRecords[recordIdx].entityManager.get();
+				}
+				return nullptr;
+			}
+
 			for (Record& record : mRecords)
 			{
-				record.entityManager.get().TEMPLATE_MSVC_EMSCRIPTEN_FIX getAllEntityComponents(entity, outComponents);
+				if (record.entityManager.get().hasEntity(entity))
+				{
+					return &record.entityManager.get();
+				}
+			}
+			return nullptr;
+		}
 
-				// if components are not empty, then we have found the entity
-				if (!outComponents.empty())
+	private:
+		struct TaskRecords
+		{
+			std::vector<size_t> recordIndexes;
+			size_t entitiesCount = 0;
+		};
+
+	private:
+		template<typename... Components, typename Executor, typename RecordProcessor>
+		void executeDistributedTasks(Executor& executor, const size_t maxTasksCount, RecordProcessor recordProcessor)
+		{
+			std::vector<std::pair<size_t, size_t>> recordSizes;
+			recordSizes.reserve(mRecords.size());
+			for (size_t i = 0; i < mRecords.size(); ++i)
+			{
+				// copying shared components acquires them from the pools, so it can't be done by the tasks
+				mRecords[i].entityManager.get().TEMPLATE_MSVC_FIX makeQueriedComponentsUnique<Components...>();
+				// this also makes sure the indexes exist before the tasks start
+				const size_t entitiesCount = mRecords[i].entityManager.get().TEMPLATE_MSVC_FIX getMatchingEntitiesCount<Components...>();
+				if (entitiesCount > 0)
 				{
+					recordSizes.emplace_back(entitiesCount, i);
+				}
+			}
+
+			if (recordSizes.empty())
+			{
+				return;
+			}
+
+			// the largest managers go first, each of them to the least loaded task
+			std::sort(recordSizes.begin(), recordSizes.end(), [](const auto& a, const auto& b) {
+				return a.first > b.first;
+			});
+
+			// have to use this weird syntax because it otherwise can break on MSVC is someone
+			// inludes <windows.h> before this file without NOMINMAX defined
+			const size_t tasksCount = (std::max)(static_cast<size_t>(1), (std::min)(maxTasksCount, recordSizes.size()));
+			std::vector<TaskRecords> tasksRecords(tasksCount);
+			for (const auto& [entitiesCount, recordIdx] : recordSizes)
+			{
+				TaskRecords& leastLoadedTask = *std::min_element(tasksRecords.begin(), tasksRecords.end(), [](const TaskRecords& a, const TaskRecords& b) {
+					return a.entitiesCount < b.entitiesCount;
+				});
+				leastLoadedTask.recordIndexes.push_back(recordIdx);
+				leastLoadedTask.entitiesCount += entitiesCount;
+			}
+
+			std::vector<std::function<void()>> tasks;
+			tasks.reserve(tasksCount);
+			for (const TaskRecords& taskRecords : tasksRecords)
+			{
+				tasks.emplace_back([this, &taskRecords, &recordProcessor]() {
+					for (const size_t recordIdx : taskRecords.recordIndexes)
+					{
+						recordProcessor(mRecords[recordIdx]);
+					}
+				});
+			}
+
+			executor(tasks);
+		}
+
+		void fillRecordsByTag()
+		{
+			mRecordIdxByTag.fill(NoRecord);
+			mAreTagsUnique = true;
+			for (size_t i = 0; i < mRecords.size(); ++i)
+			{
+				const EntitySlots::Tag tag = mRecords[i].entityManager.get().getEntityTag();
+				if (tag == 0 || mRecordIdxByTag[tag] != NoRecord)
+				{
+					mAreTagsUnique = false;
 					return;
 				}
+				mRecordIdxByTag[tag] = i;
 			}
 		}
 
 	private:
+		// have to use this weird syntax because it otherwise can break on MSVC is someone
+		// inludes <windows.h> before this file without NOMINMAX defined
+		constexpr static size_t NoRecord = (std::numeric_limits<size_t>::max)();
+
 		std::vector<Record> mRecords;
+		std::array<size_t, (std::numeric_limits<EntitySlots::Tag>::max)() + 1> mRecordIdxByTag;
+		bool mAreTagsUnique = false;
 	};
 } // namespace RaccoonEcs
@@ -30,6 +30,12 @@ namespace RaccoonEcs
 			mManager.template removeComponent<ComponentType>(mEntity);
 		}
 
+		template<typename ComponentType>
+		void setComponentEnabled(const bool isEnabled)
+		{
+			mManager.template setComponentEnabled<ComponentType>(mEntity, isEnabled);
+		}
+
 		template<typename... Components>
 		std::tuple<Components*...> getComponents()
 		{
@@ -54,6 +60,12 @@ namespace RaccoonEcs
 			mManager.template scheduleRemoveComponent<ComponentType>(mEntity);
 		}
 
+		template<typename ComponentType>
+		void scheduleSetComponentEnabled(const bool isEnabled)
+		{
+			mManager.template scheduleSetComponentEnabled<ComponentType>(mEntity, isEnabled);
+		}
+
 		void scheduleRemoveEntity()
 		{
 			mManager.scheduleRemoveEntity(mEntity);
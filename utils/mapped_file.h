@@ -0,0 +1,93 @@
+#pragma once
+
+#if defined(__unix__) || defined(__APPLE__)
+
+#include <cstddef>
+#include <memory>
+#include <span>
+#include <string>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "../error_handling.h"
+
+namespace RaccoonEcs
+{
+	/**
+	 * @brief A file mapped into memory with private pages, POSIX only
+	 *
+	 * The pages are loaded lazily and stay shared with the page cache until they are written,
+	 * then the writing process gets its own copy, the file itself is never modified.
+	 * Can be used as the data of SnapshotSerializerImpl::loadInPlace
+	 */
+	class MappedFile
+	{
+	public:
+		/**
+		 * @return the mapped file or nullptr if the file can't be opened or mapped
+		 */
+		[[nodiscard]] static std::shared_ptr<MappedFile> Open(const std::string& path)
+		{
+			const int fileDescriptor = ::open(path.c_str(), O_RDONLY);
+			if (fileDescriptor == -1)
+			{
+				RACCOON_ECS_ERROR("Can't open file to map: " + path);
+				return nullptr;
+			}
+
+			struct stat fileStat;
+			if (::fstat(fileDescriptor, &fileStat) == -1 || fileStat.st_size <= 0)
+			{
+				RACCOON_ECS_ERROR("Can't map an empty file or get its size: " + path);
+				::close(fileDescriptor);
+				return nullptr;
+			}
+
+			const size_t size = static_cast<size_t>(fileStat.st_size);
+			void* memory = ::mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fileDescriptor, 0);
+			// the mapping stays valid after the descriptor is closed
+			::close(fileDescriptor);
+			if (memory == MAP_FAILED)
+			{
+				RACCOON_ECS_ERROR("Can't map file: " + path);
+				return nullptr;
+			}
+
+			return std::shared_ptr<MappedFile>(new MappedFile(memory, size));
+		}
+
+		~MappedFile()
+		{
+			::munmap(mMemory, mSize);
+		}
+
+		MappedFile(const MappedFile&) = delete;
+		MappedFile& operator=(const MappedFile&) = delete;
+		MappedFile(MappedFile&&) = delete;
+		MappedFile& operator=(MappedFile&&) = delete;
+
+		/**
+		 * @return memory of the file, page-aligned
+		 */
+		[[nodiscard]] std::span<std::byte> getData() const noexcept
+		{
+			return { static_cast<std::byte*>(mMemory), mSize };
+		}
+
+	private:
+		MappedFile(void* memory, const size_t size) noexcept
+			: mMemory(memory)
+			, mSize(size)
+		{
+		}
+
+	private:
+		void* mMemory;
+		size_t mSize;
+	};
+} // namespace RaccoonEcs
+
+#endif // defined(__unix__) || defined(__APPLE__)
@@ -0,0 +1,355 @@
+#pragma once
+
+#ifdef RACCOON_ECS_COPYABLE_COMPONENTS
+
+#include <algorithm>
+#include <cstring>
+#include <deque>
+#include <unordered_map>
+#include <vector>
+
+#include "../component_change_ticks.h"
+#include "../dynamic_bitset.h"
+#include "../entity_manager.h"
+#include "../entity_slots.h"
+#include "../error_handling.h"
+
+namespace RaccoonEcs
+{
+	/**
+	 * @brief Keeps the states of a world for the last captured ticks, storing only the differences between the ticks
+	 *
+	 * The buffer keeps a shadow copy of the world as of the last capture, and for every captured tick stores
+	 * the previous values of only the components that were added, removed, enabled, disabled or changed during it.
+	 *
+	 * Trivially copyable components are compared bytewise with the shadow copy, so any write to them is captured.
+	 * Modifications of other components are detected only with change ticks, so the buffer enables change tracking
+	 * of all the registered component types. Components accessed as non-const by queries and getEntityComponents
+	 * are considered changed, request read-only components as const to keep the deltas small.
+	 * Writes to non-trivially copyable components through pointers kept from earlier calls must be marked
+	 * with markComponentChanged, otherwise they are not captured and rewinding silently restores states
+	 * that the world never had.
+	 *
+	 * Capturing scans the component vectors of the world, but copies only the changed components.
+	 * Rewinding records component events and marks the restored components as changed, but doesn't
+	 * broadcast onEntityAdded and onEntityRemoved.
+	 */
+	template<typename ComponentTypeId, typename ComponentFactory = ComponentFactoryImpl<ComponentTypeId>>
+	class RewindBufferImpl
+	{
+	public:
+		using EntityManager = EntityManagerImpl<ComponentTypeId, ComponentFactory>;
+
+	public:
+		/**
+		 * @param world  The world that will be captured and rewound, should outlive the buffer
+		 * @param maxTicksCount  Maximal amount of ticks that can be rewound, older ticks are dropped
+		 */
+		RewindBufferImpl(EntityManager& world, const size_t maxTicksCount)
+			: mWorld(world)
+			, mMaxTicksCount(maxTicksCount)
+		{
+			world.mComponentFactory.get().forEachComponentType([&world](ComponentTypeId typeId) {
+				world.setComponentChangesTracking(typeId, true);
+			});
+
+			// the shadow is empty, so this copies the whole world
+			TickDelta initialDelta = captureDelta();
+			destroyDelta(initialDelta);
+		}
+
+		~RewindBufferImpl()
+		{
+			for (TickDelta& delta : mDeltas)
+			{
+				destroyDelta(delta);
+			}
+
+			const ComponentFactory& componentFactory = mWorld.mComponentFactory.get();
+			for (auto& [typeId, shadowColumn] : mShadowColumns)
+			{
+				const auto deleterFn = componentFactory.getDeletionFn(typeId);
+				for (void* component : shadowColumn.components)
+				{
+					deleterFn(component);
+				}
+			}
+		}
+
+		RewindBufferImpl(const RewindBufferImpl&) = delete;
+		RewindBufferImpl& operator=(const RewindBufferImpl&) = delete;
+		RewindBufferImpl(RewindBufferImpl&&) = delete;
+		RewindBufferImpl& operator=(RewindBufferImpl&&) = delete;
+
+		/**
+		 * @brief Records the changes made to the world since the previous capture
+		 *
+		 * Should be called once at the end of every tick that can be rewound
+		 */
+		void captureTick()
+		{
+			mDeltas.push_back(captureDelta());
+
+			if (mDeltas.size() > mMaxTicksCount)
+			{
+				destroyDelta(mDeltas.front());
+				mDeltas.pop_front();
+			}
+		}
+
+		/**
+		 * @brief Restores the world to the state it had at the given amount of captures ago
+		 * @param ticksCount  0 to discard the changes made since the last capture, 1 to go
+		 * one more tick back and so on
+		 * @return false if the buffer doesn't have enough ticks captured
+		 *
+		 * The rewound ticks are removed from the buffer
+		 */
+		bool rewind(const size_t ticksCount)
+		{
+			if (ticksCount > mDeltas.size())
+			{
+				RACCOON_ECS_ERROR(std::string("Trying to rewind ") + std::to_string(ticksCount) + " ticks, but only " + std::to_string(mDeltas.size()) + " were captured");
+				return false;
+			}
+
+			TickDelta pendingDelta = captureDelta();
+			applyDelta(pendingDelta);
+
+			for (size_t i = 0; i < ticksCount; ++i)
+			{
+				applyDelta(mDeltas.back());
+				mDeltas.pop_back();
+			}
+
+			// the restored components are now the same as in the shadow, so they shouldn't be captured again
+			mLastCapturedTick = mWorld.advanceChangeTick();
+			return true;
+		}
+
+		/**
+		 * @return amount of ticks that can be rewound
+		 */
+		[[nodiscard]] size_t getCapturedTicksCount() const noexcept
+		{
+			return mDeltas.size();
+		}
+
+	private:
+		struct ComponentUndo
+		{
+			ComponentTypeId typeId;
+			Entity::RawId entityIdx;
+			// owned copy of the previous state of the component, nullptr if the entity didn't have it
+			void* component;
+			bool isEnabled;
+		};
+
+		struct SlotUndo
+		{
+			Entity::RawId entityIdx;
+			EntitySlots::Slot slot;
+		};
+
+		struct TickDelta
+		{
+			std::vector<ComponentUndo> components;
+			std::vector<SlotUndo> slots;
+			size_t slotsCount = 0;
+			Entity::RawId firstFreeSlot = EntitySlots::Slot::NoNextSlot;
+		};
+
+		struct ShadowColumn
+		{
+			std::vector<void*> components;
+			DynamicBitset disabledFlags;
+		};
+
+	private:
+		TickDelta captureDelta()
+		{
+			TickDelta delta;
+
+			// indexes cache entity handles, so components of reused or revived entities should be
+			// restored with the slot even if their content didn't change
+			const DynamicBitset changedSlots = collectChangedSlots();
+			mWorld.mComponentFactory.get().forEachComponentType([this, &delta, &changedSlots](ComponentTypeId typeId) {
+				captureComponentsDelta(typeId, delta, changedSlots);
+			});
+			captureSlotsDelta(delta);
+
+			mLastCapturedTick = mWorld.advanceChangeTick();
+			return delta;
+		}
+
+		DynamicBitset collectChangedSlots() const
+		{
+			const EntitySlots& worldSlots = mWorld.mEntitySlots;
+			const size_t worldSlotsCount = worldSlots.size();
+			const size_t shadowSlotsCount = mShadowSlots.size();
+
+			DynamicBitset changedSlots;
+			changedSlots.resize(std::max(worldSlotsCount, shadowSlotsCount));
+			for (size_t idx = 0; idx < changedSlots.size(); ++idx)
+			{
+				if (idx >= worldSlotsCount || idx >= shadowSlotsCount || !isSameSlot(worldSlots.getSlot(idx), mShadowSlots.getSlot(idx)))
+				{
+					changedSlots.set(idx);
+				}
+			}
+			return changedSlots;
+		}
+
+		void captureComponentsDelta(ComponentTypeId typeId, TickDelta& delta, const DynamicBitset& changedSlots)
+		{
+			const auto& worldComponents = mWorld.mComponents;
+			const std::vector<void*>& worldVector = worldComponents.getComponentVectorById(typeId);
+			const auto* worldTags = worldComponents.getTagStorageById(typeId);
+			const DynamicBitset* worldDisabledFlags = worldComponents.getDisabledFlags(typeId);
+			const auto* worldTicks = mWorld.mComponentChangeTicks.getTicks(typeId);
+
+			ShadowColumn& shadowColumn = mShadowColumns[typeId];
+
+			const size_t worldSize = worldTags ? worldTags->flags.size() : worldVector.size();
+			if (shadowColumn.components.size() < worldSize)
+			{
+				shadowColumn.components.resize(worldSize, nullptr);
+				shadowColumn.disabledFlags.resize(worldSize);
+			}
+
+			const auto cloneFn = mWorld.mComponentFactory.get().getCloneFn(typeId);
+			// tags have no content, and trivially copyable components are compared directly instead of trusting ticks
+			const size_t comparableSize = worldTags ? 0 : mWorld.mComponentFactory.get().getTriviallyCopyableComponentSize(typeId);
+			const size_t endIdx = shadowColumn.components.size();
+			for (size_t idx = 0; idx < endIdx; ++idx)
+			{
+				void* worldComponent = nullptr;
+				if (idx < worldSize)
+				{
+					worldComponent = worldTags ? (worldTags->flags.test(idx) ? worldTags->instance : nullptr) : worldVector[idx];
+				}
+
+				void*& shadowComponent = shadowColumn.components[idx];
+				if (worldComponent == nullptr && shadowComponent == nullptr)
+				{
+					continue;
+				}
+
+				const bool isWorldDisabled = worldComponent != nullptr && worldDisabledFlags != nullptr && idx < worldDisabledFlags->size() && worldDisabledFlags->test(idx);
+				const bool isShadowDisabled = shadowColumn.disabledFlags.test(idx);
+				const bool isChanged = worldComponent == nullptr
+					|| shadowComponent == nullptr
+					|| (idx < changedSlots.size() && changedSlots.test(idx))
+					|| isWorldDisabled != isShadowDisabled
+					|| (comparableSize > 0
+							? std::memcmp(worldComponent, shadowComponent, comparableSize) != 0
+							: (worldTicks != nullptr && EntityManager::ComponentChangeTicks::getTick(*worldTicks, idx) > mLastCapturedTick));
+
+				if (isChanged)
+				{
+					delta.components.push_back({ typeId, static_cast<Entity::RawId>(idx), shadowComponent, !isShadowDisabled });
+					shadowComponent = worldComponent ? cloneFn(worldComponent) : nullptr;
+					shadowColumn.disabledFlags.assign(idx, isWorldDisabled);
+				}
+			}
+		}
+
+		void captureSlotsDelta(TickDelta& delta)
+		{
+			const EntitySlots& worldSlots = mWorld.mEntitySlots;
+
+			delta.slotsCount = mShadowSlots.size();
+			delta.firstFreeSlot = mShadowSlots.getFirstFreeSlot();
+
+			const size_t worldSlotsCount = worldSlots.size();
+			for (size_t idx = 0; idx < delta.slotsCount; ++idx)
+			{
+				if (idx >= worldSlotsCount || !isSameSlot(worldSlots.getSlot(idx), mShadowSlots.getSlot(idx)))
+				{
+					delta.slots.push_back({ static_cast<Entity::RawId>(idx), mShadowSlots.getSlot(idx) });
+				}
+			}
+
+			for (size_t idx = 0; idx < worldSlotsCount; ++idx)
+			{
+				if (idx >= delta.slotsCount || !isSameSlot(worldSlots.getSlot(idx), mShadowSlots.getSlot(idx)))
+				{
+					mShadowSlots.restoreSlot(idx, worldSlots.getSlot(idx));
+				}
+			}
+			mShadowSlots.restoreFreeList(worldSlotsCount, worldSlots.getFirstFreeSlot());
+		}
+
+		/**
+		 * @brief Reverts the world and the shadow to the state before the delta, takes ownership of the stored components
+		 */
+		void applyDelta(TickDelta& delta)
+		{
+			// components can exist only on alive entities, so remove them before the entities are restored
+			for (const ComponentUndo& undo : delta.components)
+			{
+				if (mWorld.mComponents.hasComponent(undo.typeId, undo.entityIdx))
+				{
+					mWorld.removeComponent(mWorld.mEntitySlots.makeEntity(undo.entityIdx), undo.typeId);
+				}
+			}
+
+			for (const SlotUndo& undo : delta.slots)
+			{
+				mWorld.mEntitySlots.restoreSlot(undo.entityIdx, undo.slot);
+				mShadowSlots.restoreSlot(undo.entityIdx, undo.slot);
+			}
+			mWorld.mEntitySlots.restoreFreeList(delta.slotsCount, delta.firstFreeSlot);
+			mShadowSlots.restoreFreeList(delta.slotsCount, delta.firstFreeSlot);
+
+			const ComponentFactory& componentFactory = mWorld.mComponentFactory.get();
+			for (const ComponentUndo& undo : delta.components)
+			{
+				ShadowColumn& shadowColumn = mShadowColumns[undo.typeId];
+				void*& shadowComponent = shadowColumn.components[undo.entityIdx];
+				componentFactory.getDeletionFn(undo.typeId)(shadowComponent);
+				shadowComponent = undo.component;
+				shadowColumn.disabledFlags.assign(undo.entityIdx, !undo.isEnabled);
+
+				if (undo.component != nullptr)
+				{
+					const Entity entity = mWorld.mEntitySlots.makeEntity(undo.entityIdx);
+					mWorld.addComponent(entity, componentFactory.getCloneFn(undo.typeId)(undo.component), undo.typeId);
+					if (!undo.isEnabled)
+					{
+						mWorld.setComponentEnabled(entity, undo.typeId, false);
+					}
+				}
+			}
+
+			delta.components.clear();
+		}
+
+		void destroyDelta(TickDelta& delta)
+		{
+			const ComponentFactory& componentFactory = mWorld.mComponentFactory.get();
+			for (const ComponentUndo& undo : delta.components)
+			{
+				componentFactory.getDeletionFn(undo.typeId)(undo.component);
+			}
+			delta.components.clear();
+		}
+
+		static bool isSameSlot(const EntitySlots::Slot& first, const EntitySlots::Slot& second) noexcept
+		{
+			return first.version == second.version && first.nextFreeSlot == second.nextFreeSlot;
+		}
+
+	private:
+		EntityManager& mWorld;
+		const size_t mMaxTicksCount;
+
+		std::unordered_map<ComponentTypeId, ShadowColumn> mShadowColumns;
+		EntitySlots mShadowSlots;
+		ChangeTick mLastCapturedTick = 0;
+
+		std::deque<TickDelta> mDeltas;
+	};
+} // namespace RaccoonEcs
+
+#endif // RACCOON_ECS_COPYABLE_COMPONENTS
@@ -0,0 +1,286 @@
+#pragma once
+
+#if defined(__unix__) || defined(__APPLE__)
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <new>
+#include <span>
+#include <string>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "../error_handling.h"
+#include "snapshot_serializer.h"
+
+namespace RaccoonEcs
+{
+	/**
+	 * @brief Layout of a shared memory region with two buffers of world snapshots
+	 *
+	 * The writer fills the buffer that is not the latest one and then increases the sequence, so readers
+	 * always have one consistent buffer. A reader detects that its buffer started to be overwritten while
+	 * it was being copied by checking the sequence that is being written (a seqlock).
+	 */
+	struct SharedWorldRegionHeader
+	{
+		constexpr static std::uint32_t RegionMagic = 0x57534552u; // "RESW"
+		constexpr static std::uint32_t FormatVersion = 1;
+		// buffers go after the header, aligned to cache lines
+		constexpr static size_t BuffersOffset = 128;
+
+		std::uint32_t magic;
+		std::uint32_t formatVersion;
+		std::uint64_t bufferCapacity;
+		// amount of published snapshots, the latest one is in the buffer (sequence % 2)
+		std::atomic<std::uint64_t> sequence;
+		// sequence of the snapshot that is being written or was written last
+		std::atomic<std::uint64_t> writingSequence;
+		std::atomic<std::uint64_t> dataSizes[2];
+
+		[[nodiscard]] static size_t GetRegionSize(const size_t bufferCapacity) noexcept
+		{
+			return BuffersOffset + bufferCapacity * 2;
+		}
+	};
+
+	static_assert(std::atomic<std::uint64_t>::is_always_lock_free, "Atomics in shared memory need to be lock-free");
+	static_assert(sizeof(SharedWorldRegionHeader) <= SharedWorldRegionHeader::BuffersOffset, "Shared world region header doesn't fit before the buffers");
+
+	/**
+	 * @brief Publishes snapshots of selected component types of a world to POSIX shared memory, POSIX only
+	 *
+	 * Publishing serializes the world with SnapshotSerializerImpl and copies it into the shared memory,
+	 * it never waits for the readers. Read the snapshots from other processes with SharedWorldReader
+	 * and load them with SnapshotSerializerImpl::load.
+	 */
+	template<typename ComponentTypeId, typename ComponentFactory = ComponentFactoryImpl<ComponentTypeId>>
+	class SharedWorldExporterImpl
+	{
+	public:
+		using EntityManager = EntityManagerImpl<ComponentTypeId, ComponentFactory>;
+		using SnapshotSerializer = SnapshotSerializerImpl<ComponentTypeId, ComponentFactory>;
+
+	public:
+		/**
+		 * @param name  Name of the shared memory object, e.g. "/game-world", an existing object is unlinked
+		 * and replaced with a new one, readers that still map the old object keep it until they close it
+		 * @param bufferCapacity  Maximal size of one snapshot in bytes
+		 * @param serializer  Serializer with the exported types registered, should outlive the exporter
+		 * @param componentTypes  Types of components that will be exported
+		 * @return the exporter or nullptr if the shared memory can't be created
+		 */
+		[[nodiscard]] static std::unique_ptr<SharedWorldExporterImpl> Create(const std::string& name, const size_t bufferCapacity, const SnapshotSerializer& serializer, std::vector<ComponentTypeId> componentTypes)
+		{
+			// resizing an existing object would make the readers that map it crash on access, so it gets a new one
+			::shm_unlink(name.c_str());
+			const int fileDescriptor = ::shm_open(name.c_str(), O_CREAT | O_EXCL | O_RDWR, 0644);
+			if (fileDescriptor == -1)
+			{
+				RACCOON_ECS_ERROR("Can't create shared memory object: " + name);
+				return nullptr;
+			}
+
+			const size_t regionSize = SharedWorldRegionHeader::GetRegionSize(bufferCapacity);
+			void* memory = MAP_FAILED;
+			if (::ftruncate(fileDescriptor, static_cast<off_t>(regionSize)) == 0)
+			{
+				memory = ::mmap(nullptr, regionSize, PROT_READ | PROT_WRITE, MAP_SHARED, fileDescriptor, 0);
+			}
+			::close(fileDescriptor);
+			if (memory == MAP_FAILED)
+			{
+				RACCOON_ECS_ERROR("Can't map shared memory object: " + name);
+				::shm_unlink(name.c_str());
+				return nullptr;
+			}
+
+			SharedWorldRegionHeader* header = new (memory) SharedWorldRegionHeader();
+			header->formatVersion = SharedWorldRegionHeader::FormatVersion;
+			header->bufferCapacity = bufferCapacity;
+			header->sequence.store(0, std::memory_order_relaxed);
+			header->writingSequence.store(0, std::memory_order_relaxed);
+			header->dataSizes[0].store(0, std::memory_order_relaxed);
+			header->dataSizes[1].store(0, std::memory_order_relaxed);
+			// readers check the magic to know that the header is ready
+			std::atomic_thread_fence(std::memory_order_release);
+			header->magic = SharedWorldRegionHeader::RegionMagic;
+
+			return std::unique_ptr<SharedWorldExporterImpl>(new SharedWorldExporterImpl(name, header, regionSize, serializer, std::move(componentTypes)));
+		}
+
+		~SharedWorldExporterImpl()
+		{
+			::munmap(mHeader, mRegionSize);
+			::shm_unlink(mName.c_str());
+		}
+
+		SharedWorldExporterImpl(const SharedWorldExporterImpl&) = delete;
+		SharedWorldExporterImpl& operator=(const SharedWorldExporterImpl&) = delete;
+		SharedWorldExporterImpl(SharedWorldExporterImpl&&) = delete;
+		SharedWorldExporterImpl& operator=(SharedWorldExporterImpl&&) = delete;
+
+		/**
+		 * @brief Writes the current state of the world and makes it the latest snapshot for the readers
+		 * @return false if the snapshot can't be serialized or doesn't fit into the buffer,
+		 * the previous snapshot stays the latest then
+		 */
+		bool publish(const EntityManager& world)
+		{
+			mSerializedData.clear();
+			if (!mSerializer.save(world, mSerializedData, mComponentTypes))
+			{
+				return false;
+			}
+
+			if (mSerializedData.size() > mHeader->bufferCapacity)
+			{
+				RACCOON_ECS_ERROR("World snapshot of " + std::to_string(mSerializedData.size()) + " bytes doesn't fit into shared memory buffer of " + std::to_string(mHeader->bufferCapacity) + " bytes");
+				return false;
+			}
+
+			// only this process writes the sequence
+			const std::uint64_t nextSequence = mHeader->sequence.load(std::memory_order_relaxed) + 1;
+			const size_t bufferIdx = static_cast<size_t>(nextSequence % 2);
+			std::byte* buffer = static_cast<std::byte*>(static_cast<void*>(mHeader)) + SharedWorldRegionHeader::BuffersOffset + bufferIdx * mHeader->bufferCapacity;
+			mHeader->writingSequence.store(nextSequence, std::memory_order_relaxed);
+			std::atomic_thread_fence(std::memory_order_release);
+			std::memcpy(buffer, mSerializedData.data(), mSerializedData.size());
+			mHeader->dataSizes[bufferIdx].store(mSerializedData.size(), std::memory_order_relaxed);
+			mHeader->sequence.store(nextSequence, std::memory_order_release);
+			return true;
+		}
+
+	private:
+		SharedWorldExporterImpl(const std::string& name, SharedWorldRegionHeader* header, const size_t regionSize, const SnapshotSerializer& serializer, std::vector<ComponentTypeId>&& componentTypes)
+			: mName(name)
+			, mHeader(header)
+			, mRegionSize(regionSize)
+			, mSerializer(serializer)
+			, mComponentTypes(std::move(componentTypes))
+		{
+		}
+
+	private:
+		const std::string mName;
+		SharedWorldRegionHeader* mHeader;
+		const size_t mRegionSize;
+		const SnapshotSerializer& mSerializer;
+		const std::vector<ComponentTypeId> mComponentTypes;
+		// kept between the calls to avoid reallocations
+		std::vector<std::byte> mSerializedData;
+	};
+
+	/**
+	 * @brief Reads snapshots published by SharedWorldExporterImpl from another process, POSIX only
+	 */
+	class SharedWorldReader
+	{
+	public:
+		/**
+		 * @return the reader or nullptr if the shared memory doesn't exist or is not initialized yet
+		 */
+		[[nodiscard]] static std::unique_ptr<SharedWorldReader> Open(const std::string& name)
+		{
+			const int fileDescriptor = ::shm_open(name.c_str(), O_RDONLY, 0);
+			if (fileDescriptor == -1)
+			{
+				return nullptr;
+			}
+
+			struct stat fileStat;
+			void* memory = MAP_FAILED;
+			size_t regionSize = 0;
+			if (::fstat(fileDescriptor, &fileStat) == 0 && static_cast<size_t>(fileStat.st_size) >= SharedWorldRegionHeader::BuffersOffset)
+			{
+				regionSize = static_cast<size_t>(fileStat.st_size);
+				memory = ::mmap(nullptr, regionSize, PROT_READ, MAP_SHARED, fileDescriptor, 0);
+			}
+			::close(fileDescriptor);
+			if (memory == MAP_FAILED)
+			{
+				return nullptr;
+			}
+
+			const SharedWorldRegionHeader* header = static_cast<const SharedWorldRegionHeader*>(memory);
+			const bool isReady = header->magic == SharedWorldRegionHeader::RegionMagic;
+			std::atomic_thread_fence(std::memory_order_acquire);
+			if (!isReady || header->formatVersion != SharedWorldRegionHeader::FormatVersion || SharedWorldRegionHeader::GetRegionSize(header->bufferCapacity) > regionSize)
+			{
+				::munmap(memory, regionSize);
+				return nullptr;
+			}
+
+			return std::unique_ptr<SharedWorldReader>(new SharedWorldReader(header, regionSize));
+		}
+
+		~SharedWorldReader()
+		{
+			::munmap(const_cast<SharedWorldRegionHeader*>(mHeader), mRegionSize);
+		}
+
+		SharedWorldReader(const SharedWorldReader&) = delete;
+		SharedWorldReader& operator=(const SharedWorldReader&) = delete;
+		SharedWorldReader(SharedWorldReader&&) = delete;
+		SharedWorldReader& operator=(SharedWorldReader&&) = delete;
+
+		/**
+		 * @brief Copies the latest published snapshot, retries if the writer overwrote it during the copy
+		 * @param outData  Replaced with the snapshot data
+		 * @return sequence number of the copied snapshot, 0 if nothing was published yet or the region is corrupted
+		 */
+		std::uint64_t readLatest(std::vector<std::byte>& outData) const
+		{
+			while (true)
+			{
+				const std::uint64_t sequence = mHeader->sequence.load(std::memory_order_acquire);
+				if (sequence == 0)
+				{
+					outData.clear();
+					return 0;
+				}
+
+				const size_t bufferIdx = static_cast<size_t>(sequence % 2);
+				const size_t dataSize = static_cast<size_t>(mHeader->dataSizes[bufferIdx].load(std::memory_order_relaxed));
+				if (dataSize > mHeader->bufferCapacity)
+				{
+					// the exporter never publishes snapshots that don't fit, so the region is corrupted or made by another build
+					RACCOON_ECS_ERROR("Shared world snapshot of " + std::to_string(dataSize) + " bytes doesn't fit into the buffer of " + std::to_string(mHeader->bufferCapacity) + " bytes");
+					outData.clear();
+					return 0;
+				}
+
+				const std::byte* buffer = static_cast<const std::byte*>(static_cast<const void*>(mHeader)) + SharedWorldRegionHeader::BuffersOffset + bufferIdx * mHeader->bufferCapacity;
+				outData.resize(dataSize);
+				std::memcpy(outData.data(), buffer, dataSize);
+
+				std::atomic_thread_fence(std::memory_order_acquire);
+				// the writer touches our buffer only when writing the snapshot after the next one
+				if (mHeader->writingSequence.load(std::memory_order_relaxed) - sequence < 2)
+				{
+					return sequence;
+				}
+			}
+		}
+
+	private:
+		SharedWorldReader(const SharedWorldRegionHeader* header, const size_t regionSize) noexcept
+			: mHeader(header)
+			, mRegionSize(regionSize)
+		{
+		}
+
+	private:
+		const SharedWorldRegionHeader* mHeader;
+		size_t mRegionSize;
+	};
+} // namespace RaccoonEcs
+
+#endif // defined(__unix__) || defined(__APPLE__)
@@ -0,0 +1,632 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <memory>
+#include <span>
+#include <string>
+#include <type_traits>
+#include <unordered_map>
+#include <vector>
+
+#include "../component_factory.h"
+#include "../dynamic_bitset.h"
+#include "../entity_manager.h"
+#include "../entity_slots.h"
+#include "../error_handling.h"
+
+namespace RaccoonEcs
+{
+	/**
+	 * @brief Saves the whole state of a world into a compact binary blob and loads it back
+	 *
+	 * Stores entity slots (versions and the free list), the entity tag and components with their enabled state.
+	 * Trivially copyable components are written as raw blocks, other types need serialization hooks.
+	 * Loading creates entities and components in bulk, without going through addEntity and addComponent,
+	 * so no events are recorded, no change ticks are updated and indexes are rebuilt on the next query.
+	 *
+	 * Component type ids are written bytewise, so they need to be trivially copyable (e.g. enums or integers).
+	 * Snapshots are not portable between platforms with different endianness or component layouts.
+	 *
+	 * Snapshots saved with Layout::Mappable can be loaded with loadInPlace, then raw components use the
+	 * snapshot memory directly instead of being copied (e.g. from a file mapped with MappedFile).
+	 */
+	template<typename ComponentTypeId, typename ComponentFactory = ComponentFactoryImpl<ComponentTypeId>>
+	class SnapshotSerializerImpl
+	{
+	public:
+		using EntityManager = EntityManagerImpl<ComponentTypeId, ComponentFactory>;
+		// appends the serialized component to the data
+		using SerializeFn = std::function<void(const void* component, std::vector<std::byte>& inOutData)>;
+		// fills a default-constructed component from exactly the bytes written by SerializeFn, returns false on malformed data
+		using DeserializeFn = std::function<bool(void* component, std::span<const std::byte> data)>;
+
+		enum class Layout : std::uint8_t
+		{
+			// raw components are packed without gaps
+			Packed,
+			// raw components are stored as aligned component pool slots that can be used in place
+			Mappable,
+		};
+
+		static_assert(std::is_trivially_copyable_v<ComponentTypeId>, "Component type ids are written bytewise, so they need to be trivially copyable");
+
+	public:
+		/**
+		 * @brief Registers a tag or a trivially copyable component that will be written as raw bytes
+		 */
+		template<typename ComponentType>
+		void registerComponent()
+		{
+			static_assert(std::is_empty_v<ComponentType> || std::is_trivially_copyable_v<ComponentType>, "Components that are not trivially copyable need serialization hooks");
+
+			TypeSerializer& typeSerializer = mTypeSerializers[ComponentType::GetTypeId()];
+			if constexpr (std::is_empty_v<ComponentType>)
+			{
+				typeSerializer.storageType = StorageType::Tag;
+			}
+			else
+			{
+				typeSerializer.storageType = StorageType::Raw;
+				typeSerializer.componentSize = sizeof(ComponentType);
+				typeSerializer.slotSize = ComponentPool<ComponentType>::getSlotSize();
+				typeSerializer.slotAlignment = ComponentPool<ComponentType>::getSlotAlignment();
+				typeSerializer.loadRawComponentsFn = [](const ComponentFactory& componentFactory, const std::byte* bytes, const size_t componentsCount, const size_t stride, std::vector<void*>& outComponents) {
+					componentFactory.template getComponentPool<ComponentType>()->acquireComponentsFromBytes(bytes, componentsCount, stride, outComponents);
+				};
+				typeSerializer.writeSlotImageFn = &ComponentPool<ComponentType>::writeSlotImage;
+				typeSerializer.adoptExternalSlotsFn = [](const ComponentFactory& componentFactory, std::byte* slots, const size_t componentsCount, std::shared_ptr<void> memoryOwner) {
+					return componentFactory.template getComponentPool<ComponentType>()->adoptExternalSlots(slots, componentsCount, std::move(memoryOwner));
+				};
+			}
+		}
+
+		/**
+		 * @brief Registers a component that will be written with the given hooks
+		 */
+		template<typename ComponentType>
+		void registerComponent(SerializeFn&& serializeFn, DeserializeFn&& deserializeFn)
+		{
+			TypeSerializer& typeSerializer = mTypeSerializers[ComponentType::GetTypeId()];
+			typeSerializer.storageType = StorageType::Custom;
+			typeSerializer.serializeFn = std::move(serializeFn);
+			typeSerializer.deserializeFn = std::move(deserializeFn);
+		}
+
+		/**
+		 * @brief Writes the state of the world to the end of outData
+		 * @param layout  With Layout::Mappable the blocks are aligned relative to the beginning of outData,
+		 * so the snapshot should be stored from the beginning of a file or an aligned buffer
+		 * @return false if the world has components of types that were not registered, such components are not written
+		 */
+		bool save(const EntityManager& world, std::vector<std::byte>& outData, const Layout layout = Layout::Packed) const
+		{
+			return saveFiltered(world, outData, layout, [](ComponentTypeId) { return true; });
+		}
+
+		/**
+		 * @brief Same as save, but writes only components of the listed types, all entities are still written
+		 */
+		bool save(const EntityManager& world, std::vector<std::byte>& outData, const std::vector<ComponentTypeId>& componentTypes, const Layout layout = Layout::Packed) const
+		{
+			return saveFiltered(world, outData, layout, [&componentTypes](ComponentTypeId typeId) {
+				return std::find(componentTypes.begin(), componentTypes.end(), typeId) != componentTypes.end();
+			});
+		}
+
+		/**
+		 * @brief Replaces the state of the world with the state stored in the data
+		 * @return false if the data is malformed or contains unregistered types, the world is left empty in this case
+		 *
+		 * The world should use a component factory with all the stored types registered.
+		 * A world with a non-zero entity tag (see EntityManagerImpl::setEntityTag) can load only snapshots
+		 * saved with the same tag, a world without a tag gets the tag of the snapshot
+		 */
+		bool load(EntityManager& world, std::span<const std::byte> data) const
+		{
+			return loadSafely(world, data, nullptr);
+		}
+
+		/**
+		 * @brief Same as load, but raw components of snapshots saved with Layout::Mappable use the data directly
+		 * @param data  Snapshot memory aligned at least as the components, writes to the components modify it,
+		 * so use private mappings (see MappedFile) to get the pages copied on the first write.
+		 * One mapping can back only one world, the load fails if the pools still use the memory,
+		 * use a separate MappedFile::Open for each world
+		 * @param dataOwner  Keeps the data alive, the component pools hold it until they are destroyed
+		 *
+		 * Components of snapshots saved with Layout::Packed are copied the same way as with load.
+		 * Components that contain pointers should not be registered as raw
+		 */
+		bool loadInPlace(EntityManager& world, std::span<std::byte> data, std::shared_ptr<void> dataOwner) const
+		{
+			InPlaceData inPlaceData{ data.data(), std::move(dataOwner) };
+			return loadSafely(world, data, &inPlaceData);
+		}
+
+	private:
+		enum class StorageType : std::uint8_t
+		{
+			Tag,
+			Raw,
+			Custom,
+		};
+
+		using LoadRawComponentsFn = void (*)(const ComponentFactory&, const std::byte*, size_t, size_t, std::vector<void*>&);
+		using WriteSlotImageFn = void (*)(const void*, std::byte*);
+		using AdoptExternalSlotsFn = bool (*)(const ComponentFactory&, std::byte*, size_t, std::shared_ptr<void>);
+
+		struct TypeSerializer
+		{
+			StorageType storageType = StorageType::Custom;
+			size_t componentSize = 0;
+			size_t slotSize = 0;
+			size_t slotAlignment = 1;
+			LoadRawComponentsFn loadRawComponentsFn = nullptr;
+			WriteSlotImageFn writeSlotImageFn = nullptr;
+			AdoptExternalSlotsFn adoptExternalSlotsFn = nullptr;
+			SerializeFn serializeFn;
+			DeserializeFn deserializeFn;
+		};
+
+		// memory of the snapshot that raw components can use in place, see loadInPlace
+		struct InPlaceData
+		{
+			std::byte* begin;
+			std::shared_ptr<void> owner;
+		};
+
+		// sequential reader of the snapshot data, all reads fail after the data ends
+		struct DataReader
+		{
+			std::span<const std::byte> data;
+			const std::byte* begin = data.data();
+			Layout layout = Layout::Packed;
+
+			template<typename T>
+			bool readValue(T& outValue)
+			{
+				if (data.size() < sizeof(T))
+				{
+					return false;
+				}
+				std::memcpy(&outValue, data.data(), sizeof(T));
+				data = data.subspan(sizeof(T));
+				return true;
+			}
+
+			bool readBytes(const size_t bytesCount, std::span<const std::byte>& outBytes)
+			{
+				if (data.size() < bytesCount)
+				{
+					return false;
+				}
+				outBytes = data.first(bytesCount);
+				data = data.subspan(bytesCount);
+				return true;
+			}
+
+			bool readBitset(DynamicBitset& outBitset)
+			{
+				std::uint64_t bitsCount = 0;
+				std::span<const std::byte> wordBytes;
+				if (!readValue(bitsCount) || bitsCount > data.size() * 8 || !readBytes(DynamicBitset::getWordsCount(static_cast<size_t>(bitsCount)) * sizeof(DynamicBitset::Word), wordBytes))
+				{
+					return false;
+				}
+
+				std::vector<DynamicBitset::Word> words(wordBytes.size() / sizeof(DynamicBitset::Word));
+				if (!words.empty())
+				{
+					std::memcpy(words.data(), wordBytes.data(), wordBytes.size());
+				}
+				outBitset.assignWords(std::move(words), static_cast<size_t>(bitsCount));
+				return true;
+			}
+
+			bool skipPadding(const size_t alignment)
+			{
+				const size_t offset = static_cast<size_t>(data.data() - begin);
+				const size_t paddingSize = (alignment - offset % alignment) % alignment;
+				std::span<const std::byte> padding;
+				return readBytes(paddingSize, padding);
+			}
+		};
+
+		constexpr static std::uint32_t SnapshotMagic = 0x53434552u; // "RECS"
+		constexpr static std::uint32_t FormatVersion = 2;
+
+	private:
+		[[nodiscard]] const TypeSerializer* findTypeSerializer(ComponentTypeId typeId) const
+		{
+			auto it = mTypeSerializers.find(typeId);
+			return it == mTypeSerializers.end() ? nullptr : &it->second;
+		}
+
+		template<typename ComponentTypeFilter>
+		bool saveFiltered(const EntityManager& world, std::vector<std::byte>& outData, const Layout layout, const ComponentTypeFilter& shouldSaveType) const
+		{
+			bool isSuccessful = true;
+
+			writeValue(outData, SnapshotMagic);
+			writeValue(outData, FormatVersion);
+			writeValue(outData, static_cast<std::uint32_t>(sizeof(ComponentTypeId)));
+			writeValue(outData, layout);
+
+			const std::span<const EntitySlots::Slot> slots = world.mEntitySlots.getSlots();
+			writeValue(outData, world.mEntitySlots.getTag());
+			writeValue(outData, static_cast<std::uint64_t>(slots.size()));
+			writeValue(outData, world.mEntitySlots.getFirstFreeSlot());
+			writeBytes(outData, slots.data(), slots.size_bytes());
+
+			// the amount of types is known only at the end
+			const size_t typesCountOffset = outData.size();
+			writeValue(outData, std::uint64_t(0));
+			std::uint64_t typesCount = 0;
+
+			for (const auto& [typeId, componentVector] : world.mComponents)
+			{
+				if (!shouldSaveType(typeId))
+				{
+					continue;
+				}
+
+				const TypeSerializer* typeSerializer = findTypeSerializer(typeId);
+				if (typeSerializer == nullptr || typeSerializer->storageType == StorageType::Tag)
+				{
+					RACCOON_ECS_ERROR(std::string("Component type is not registered for serialization: ") + toString(typeId));
+					isSuccessful = false;
+					continue;
+				}
+
+				DynamicBitset presentComponents;
+				presentComponents.resize(componentVector.size());
+				for (size_t entityIdx = 0; entityIdx < componentVector.size(); ++entityIdx)
+				{
+					if (componentVector[entityIdx] != nullptr)
+					{
+						presentComponents.set(entityIdx);
+					}
+				}
+
+				writeTypeHeader(outData, typeId, *typeSerializer, presentComponents);
+				if (typeSerializer->storageType == StorageType::Raw && layout == Layout::Mappable)
+				{
+					writeValue(outData, static_cast<std::uint64_t>(typeSerializer->slotSize));
+					writePadding(outData, typeSerializer->slotAlignment);
+					size_t slotOffset = outData.size();
+					outData.resize(slotOffset + presentComponents.count() * typeSerializer->slotSize);
+					presentComponents.forEachSetBit([&outData, &componentVector, &slotOffset, typeSerializer](const size_t entityIdx) {
+						typeSerializer->writeSlotImageFn(componentVector[entityIdx], outData.data() + slotOffset);
+						slotOffset += typeSerializer->slotSize;
+					});
+				}
+				else if (typeSerializer->storageType == StorageType::Raw)
+				{
+					presentComponents.forEachSetBit([&outData, &componentVector, typeSerializer](const size_t entityIdx) {
+						writeBytes(outData, componentVector[entityIdx], typeSerializer->componentSize);
+					});
+				}
+				else
+				{
+					presentComponents.forEachSetBit([&outData, &componentVector, typeSerializer](const size_t entityIdx) {
+						// the size is known only after the component is written
+						const size_t sizeOffset = outData.size();
+						writeValue(outData, std::uint64_t(0));
+						typeSerializer->serializeFn(componentVector[entityIdx], outData);
+						const std::uint64_t componentSize = static_cast<std::uint64_t>(outData.size() - sizeOffset - sizeof(std::uint64_t));
+						std::memcpy(outData.data() + sizeOffset, &componentSize, sizeof(componentSize));
+					});
+				}
+				writeBitset(outData, world.mComponents.getDisabledFlags(typeId));
+				++typesCount;
+			}
+
+			for (const auto& [typeId, tagStorage] : world.mComponents.getTagStorages())
+			{
+				if (!shouldSaveType(typeId))
+				{
+					continue;
+				}
+
+				const TypeSerializer* typeSerializer = findTypeSerializer(typeId);
+				if (typeSerializer == nullptr || typeSerializer->storageType != StorageType::Tag)
+				{
+					RACCOON_ECS_ERROR(std::string("Tag component type is not registered for serialization: ") + toString(typeId));
+					isSuccessful = false;
+					continue;
+				}
+
+				writeTypeHeader(outData, typeId, *typeSerializer, tagStorage.flags);
+				writeBitset(outData, world.mComponents.getDisabledFlags(typeId));
+				++typesCount;
+			}
+
+			std::memcpy(outData.data() + typesCountOffset, &typesCount, sizeof(typesCount));
+			return isSuccessful;
+		}
+
+		bool loadSafely(EntityManager& world, std::span<const std::byte> data, const InPlaceData* inPlaceData) const
+		{
+			const EntitySlots::Tag entityTag = world.getEntityTag();
+			world.clear();
+			if (!loadInner(world, data, inPlaceData))
+			{
+				world.clear();
+				world.mEntitySlots.setTag(entityTag);
+				return false;
+			}
+			return true;
+		}
+
+		bool loadInner(EntityManager& world, std::span<const std::byte> data, const InPlaceData* inPlaceData) const
+		{
+			DataReader reader{ data };
+
+			std::uint32_t magic = 0;
+			std::uint32_t formatVersion = 0;
+			std::uint32_t typeIdSize = 0;
+			if (!reader.readValue(magic) || !reader.readValue(formatVersion) || !reader.readValue(typeIdSize) || !reader.readValue(reader.layout)
+				|| magic != SnapshotMagic || formatVersion != FormatVersion || typeIdSize != sizeof(ComponentTypeId)
+				|| (reader.layout != Layout::Packed && reader.layout != Layout::Mappable))
+			{
+				RACCOON_ECS_ERROR("The data is not a snapshot of a compatible format");
+				return false;
+			}
+
+			EntitySlots::Tag entityTag = 0;
+			std::uint64_t slotsCount = 0;
+			Entity::RawId firstFreeSlot = EntitySlots::Slot::NoNextSlot;
+			std::span<const std::byte> slotBytes;
+			if (!reader.readValue(entityTag) || !reader.readValue(slotsCount) || !reader.readValue(firstFreeSlot)
+				|| slotsCount > reader.data.size() / sizeof(EntitySlots::Slot)
+				|| !reader.readBytes(static_cast<size_t>(slotsCount) * sizeof(EntitySlots::Slot), slotBytes))
+			{
+				RACCOON_ECS_ERROR("Entity slots in the snapshot are malformed");
+				return false;
+			}
+
+			std::vector<EntitySlots::Slot> slots(static_cast<size_t>(slotsCount));
+			if (!slots.empty())
+			{
+				std::memcpy(static_cast<void*>(slots.data()), slotBytes.data(), slotBytes.size());
+			}
+
+			if (!EntitySlots::IsFreeListValid(slots, firstFreeSlot))
+			{
+				RACCOON_ECS_ERROR("Entity slots in the snapshot are malformed");
+				return false;
+			}
+			// views like CombinedEntityManagerView remember the tags of their managers
+			if (world.getEntityTag() != 0 && world.getEntityTag() != entityTag)
+			{
+				RACCOON_ECS_ERROR("The snapshot was saved from a world with entity tag " + std::to_string(entityTag) + ", but the world has entity tag " + std::to_string(world.getEntityTag()));
+				return false;
+			}
+			world.mEntitySlots.setTag(entityTag);
+			world.mEntitySlots.assignSlots(std::move(slots), firstFreeSlot);
+
+			std::uint64_t typesCount = 0;
+			if (!reader.readValue(typesCount))
+			{
+				RACCOON_ECS_ERROR("Snapshot data ended unexpectedly");
+				return false;
+			}
+
+			for (std::uint64_t i = 0; i < typesCount; ++i)
+			{
+				if (!loadComponents(world, reader, inPlaceData))
+				{
+					return false;
+				}
+			}
+			return true;
+		}
+
+		bool loadComponents(EntityManager& world, DataReader& reader, const InPlaceData* inPlaceData) const
+		{
+			ComponentTypeId typeId;
+			StorageType storageType;
+			std::uint64_t componentSize = 0;
+			DynamicBitset presentComponents;
+			if (!reader.readValue(typeId) || !reader.readValue(storageType) || !reader.readValue(componentSize) || !reader.readBitset(presentComponents))
+			{
+				RACCOON_ECS_ERROR("Snapshot data ended unexpectedly");
+				return false;
+			}
+
+			const TypeSerializer* typeSerializer = findTypeSerializer(typeId);
+			if (typeSerializer == nullptr || typeSerializer->storageType != storageType || typeSerializer->componentSize != componentSize)
+			{
+				RACCOON_ECS_ERROR(std::string("Component type in the snapshot is not registered or was registered differently: ") + toString(typeId));
+				return false;
+			}
+
+			if (!world.mComponents.getComponentVectorById(typeId).empty() || world.mComponents.getTagStorageById(typeId) != nullptr)
+			{
+				RACCOON_ECS_ERROR(std::string("Component type is stored in the snapshot more than once: ") + toString(typeId));
+				return false;
+			}
+
+			bool areEntitiesAlive = true;
+			presentComponents.forEachSetBit([&world, &areEntitiesAlive](const size_t entityIdx) {
+				areEntitiesAlive = areEntitiesAlive && world.mEntitySlots.isAlive(entityIdx);
+			});
+			if (!areEntitiesAlive)
+			{
+				RACCOON_ECS_ERROR(std::string("Snapshot has components of removed entities, type: ") + toString(typeId));
+				return false;
+			}
+
+			const ComponentFactory& componentFactory = world.mComponentFactory.get();
+			if (storageType == StorageType::Tag)
+			{
+				auto& tagStorage = world.mComponents.getOrCreateTagStorageById(typeId);
+				tagStorage.instance = componentFactory.createComponent(typeId);
+				tagStorage.flags = std::move(presentComponents);
+			}
+			else if (!loadComponentVector(world, reader, inPlaceData, typeId, *typeSerializer, presentComponents))
+			{
+				return false;
+			}
+
+			DynamicBitset disabledFlags;
+			if (!reader.readBitset(disabledFlags))
+			{
+				RACCOON_ECS_ERROR("Snapshot data ended unexpectedly");
+				return false;
+			}
+
+			// a disabled flag without a component would make the component disabled when it is added later
+			const DynamicBitset& loadedComponents = (storageType == StorageType::Tag) ? world.mComponents.getTagStorageById(typeId)->flags : presentComponents;
+			bool areDisabledComponentsPresent = true;
+			disabledFlags.forEachSetBit([&loadedComponents, &areDisabledComponentsPresent](const size_t entityIdx) {
+				areDisabledComponentsPresent = areDisabledComponentsPresent && entityIdx < loadedComponents.size() && loadedComponents.test(entityIdx);
+			});
+			if (!areDisabledComponentsPresent)
+			{
+				RACCOON_ECS_ERROR(std::string("Snapshot has disabled flags of missing components, type: ") + toString(typeId));
+				return false;
+			}
+			if (disabledFlags.any())
+			{
+				world.mComponents.setDisabledFlags(typeId, std::move(disabledFlags));
+			}
+			return true;
+		}
+
+		bool loadComponentVector(EntityManager& world, DataReader& reader, const InPlaceData* inPlaceData, ComponentTypeId typeId, const TypeSerializer& typeSerializer, const DynamicBitset& presentComponents) const
+		{
+			const ComponentFactory& componentFactory = world.mComponentFactory.get();
+			const size_t componentsCount = presentComponents.count();
+
+			// the vector is created before any component, so the components are released if loading fails midway
+			std::vector<void*>& componentVector = world.mComponents.getOrCreateComponentVectorById(typeId);
+			componentVector.resize(presentComponents.size(), nullptr);
+
+			if (typeSerializer.storageType == StorageType::Raw)
+			{
+				size_t stride = typeSerializer.componentSize;
+				if (reader.layout == Layout::Mappable)
+				{
+					std::uint64_t slotSize = 0;
+					if (!reader.readValue(slotSize) || slotSize != typeSerializer.slotSize || !reader.skipPadding(typeSerializer.slotAlignment))
+					{
+						RACCOON_ECS_ERROR(std::string("Component slots in the snapshot have different layout, type: ") + toString(typeId));
+						return false;
+					}
+					stride = typeSerializer.slotSize;
+				}
+
+				std::span<const std::byte> componentBytes;
+				if (componentsCount > reader.data.size() / stride || !reader.readBytes(componentsCount * stride, componentBytes))
+				{
+					RACCOON_ECS_ERROR("Snapshot data ended unexpectedly");
+					return false;
+				}
+
+				std::vector<void*> loadedComponents;
+				if (inPlaceData != nullptr && reader.layout == Layout::Mappable && componentsCount > 0)
+				{
+					std::byte* slots = inPlaceData->begin + (componentBytes.data() - reader.begin);
+					if (reinterpret_cast<std::uintptr_t>(slots) % typeSerializer.slotAlignment != 0)
+					{
+						RACCOON_ECS_ERROR("Snapshot memory is not aligned enough to use components in place");
+						return false;
+					}
+
+					if (!typeSerializer.adoptExternalSlotsFn(componentFactory, slots, componentsCount, inPlaceData->owner))
+					{
+						RACCOON_ECS_ERROR(std::string("Snapshot memory is already used by components, it can back only one world, type: ") + toString(typeId));
+						return false;
+					}
+					loadedComponents.reserve(componentsCount);
+					for (size_t i = 0; i < componentsCount; ++i)
+					{
+						loadedComponents.push_back(slots + i * stride);
+					}
+				}
+				else
+				{
+					typeSerializer.loadRawComponentsFn(componentFactory, componentBytes.data(), componentsCount, stride, loadedComponents);
+				}
+
+				size_t loadedIdx = 0;
+				presentComponents.forEachSetBit([&componentVector, &loadedComponents, &loadedIdx](const size_t entityIdx) {
+					componentVector[entityIdx] = loadedComponents[loadedIdx];
+					++loadedIdx;
+				});
+				return true;
+			}
+
+			bool isSuccessful = true;
+			presentComponents.forEachSetBit([&](const size_t entityIdx) {
+				std::uint64_t componentSize = 0;
+				std::span<const std::byte> componentBytes;
+				if (!isSuccessful || !reader.readValue(componentSize) || componentSize > reader.data.size() || !reader.readBytes(static_cast<size_t>(componentSize), componentBytes))
+				{
+					isSuccessful = false;
+					return;
+				}
+
+				void* component = componentFactory.createComponent(typeId);
+				componentVector[entityIdx] = component;
+				isSuccessful = typeSerializer.deserializeFn(component, componentBytes);
+			});
+
+			if (!isSuccessful)
+			{
+				RACCOON_ECS_ERROR(std::string("Failed to deserialize components of type: ") + toString(typeId));
+			}
+			return isSuccessful;
+		}
+
+		static void writeTypeHeader(std::vector<std::byte>& outData, ComponentTypeId typeId, const TypeSerializer& typeSerializer, const DynamicBitset& presentComponents)
+		{
+			writeValue(outData, typeId);
+			writeValue(outData, typeSerializer.storageType);
+			writeValue(outData, static_cast<std::uint64_t>(typeSerializer.componentSize));
+			writeBitset(outData, &presentComponents);
+		}
+
+		static void writeBitset(std::vector<std::byte>& outData, const DynamicBitset* bitset)
+		{
+			if (bitset == nullptr)
+			{
+				writeValue(outData, std::uint64_t(0));
+				return;
+			}
+
+			const std::vector<DynamicBitset::Word>& words = bitset->getWords();
+			writeValue(outData, static_cast<std::uint64_t>(bitset->size()));
+			writeBytes(outData, words.data(), words.size() * sizeof(DynamicBitset::Word));
+		}
+
+		static void writePadding(std::vector<std::byte>& outData, const size_t alignment)
+		{
+			outData.resize(outData.size() + (alignment - outData.size() % alignment) % alignment, std::byte(0));
+		}
+
+		template<typename T>
+		static void writeValue(std::vector<std::byte>& outData, const T& value)
+		{
+			writeBytes(outData, &value, sizeof(T));
+		}
+
+		static void writeBytes(std::vector<std::byte>& outData, const void* bytes, const size_t bytesCount)
+		{
+			const size_t offset = outData.size();
+			outData.resize(offset + bytesCount);
+			if (bytesCount > 0)
+			{
+				std::memcpy(outData.data() + offset, bytes, bytesCount);
+			}
+		}
+
+	private:
+		std::unordered_map<ComponentTypeId, TypeSerializer> mTypeSerializers;
+	};
+} // namespace RaccoonEcs
@@ -0,0 +1,714 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <span>
+#include <string>
+#include <type_traits>
+#include <unordered_map>
+#include <vector>
+
+#include "../component_factory.h"
+#include "../entity_manager.h"
+#include "../entity_slots.h"
+#include "../error_handling.h"
+
+namespace RaccoonEcs
+{
+	/**
+	 * @brief Makes compact binary diffs between two states of a world and applies them to other worlds,
+	 * e.g. for delta-compressed state replication
+	 *
+	 * A diff stores the changed entity slots, so added and removed entities and the free list are reproduced exactly.
+	 * For entities that exist in both states it stores added and removed components, changed byte ranges of
+	 * components and changes of the enabled state. Components of added entities are stored whole.
+	 * Only the registered types are compared, components of other types are ignored.
+	 *
+	 * The baseline can be any manager with the previous state, e.g. a copy made with overrideBy or a manager
+	 * loaded from a snapshot with SnapshotSerializerImpl. The diff can be applied to any manager that matches
+	 * the baseline in entities and registered components, so the diff is made against the last state acknowledged by the receiver.
+	 *
+	 * Component type ids are written bytewise, so they need to be trivially copyable (e.g. enums or integers).
+	 * Diffs are not portable between platforms with different endianness or component layouts.
+	 */
+	template<typename ComponentTypeId, typename ComponentFactory = ComponentFactoryImpl<ComponentTypeId>>
+	class WorldDiffImpl
+	{
+	public:
+		using EntityManager = EntityManagerImpl<ComponentTypeId, ComponentFactory>;
+
+		struct EntityChanges
+		{
+			std::vector<Entity> removedEntities;
+			std::vector<Entity> addedEntities;
+		};
+
+		static_assert(std::is_trivially_copyable_v<ComponentTypeId>, "Component type ids are written bytewise, so they need to be trivially copyable");
+
+	public:
+		/**
+		 * @brief Registers a tag or a trivially copyable component that will be compared bytewise
+		 */
+		template<typename ComponentType>
+		void registerComponent()
+		{
+			static_assert(std::is_empty_v<ComponentType> || std::is_trivially_copyable_v<ComponentType>, "Only tags and trivially copyable components can be diffed bytewise");
+			static_assert(sizeof(ComponentType) <= MaxComponentSize, "Changed byte ranges are stored with 16-bit offsets");
+
+			mComponentSizes[ComponentType::GetTypeId()] = std::is_empty_v<ComponentType> ? 0 : sizeof(ComponentType);
+		}
+
+		/**
+		 * @brief Appends the diff that turns the baseline into the target to outDiff
+		 * @param outEntityChanges  Optionally receives the entities that were removed and added
+		 *
+		 * Compares component vectors and entity slots of the managers directly, the cost is linear
+		 * in the amount of entity ids and the registered component types
+		 */
+		void makeDiff(const EntityManager& baseline, const EntityManager& target, std::vector<std::byte>& outDiff, EntityChanges* outEntityChanges = nullptr) const
+		{
+			writeValue(outDiff, DiffMagic);
+			writeValue(outDiff, FormatVersion);
+			writeValue(outDiff, static_cast<std::uint8_t>(sizeof(ComponentTypeId)));
+
+			const std::span<const EntitySlots::Slot> baselineSlots = baseline.mEntitySlots.getSlots();
+			const std::span<const EntitySlots::Slot> targetSlots = target.mEntitySlots.getSlots();
+
+			writeValue(outDiff, static_cast<std::uint64_t>(targetSlots.size()));
+			writeValue(outDiff, target.mEntitySlots.getFirstFreeSlot());
+			const size_t changedSlotsCountOffset = outDiff.size();
+			writeValue(outDiff, std::uint64_t(0));
+
+			std::uint64_t changedSlotsCount = 0;
+			// have to use this weird syntax because it otherwise can break on MSVC is someone
+			// inludes <windows.h> before this file without NOMINMAX defined
+			const size_t slotsCount = (std::max)(baselineSlots.size(), targetSlots.size());
+			for (size_t entityIdx = 0; entityIdx < slotsCount; ++entityIdx)
+			{
+				const bool isInBaseline = entityIdx < baselineSlots.size();
+				const bool isInTarget = entityIdx < targetSlots.size();
+				if (isInBaseline && isInTarget && isSameSlot(baselineSlots[entityIdx], targetSlots[entityIdx]))
+				{
+					continue;
+				}
+
+				// slots past the end of the target are dropped when the amount of slots is restored
+				if (isInTarget)
+				{
+					writeValue(outDiff, static_cast<Entity::RawId>(entityIdx));
+					writeValue(outDiff, targetSlots[entityIdx]);
+					++changedSlotsCount;
+				}
+
+				if (outEntityChanges != nullptr)
+				{
+					if (isInBaseline && baselineSlots[entityIdx].isAlive())
+					{
+						outEntityChanges->removedEntities.push_back(baseline.mEntitySlots.makeEntity(entityIdx));
+					}
+					if (isInTarget && targetSlots[entityIdx].isAlive())
+					{
+						outEntityChanges->addedEntities.push_back(target.mEntitySlots.makeEntity(entityIdx));
+					}
+				}
+			}
+			std::memcpy(outDiff.data() + changedSlotsCountOffset, &changedSlotsCount, sizeof(changedSlotsCount));
+
+			const size_t typesCountOffset = outDiff.size();
+			writeValue(outDiff, std::uint64_t(0));
+			std::uint64_t typesCount = 0;
+			for (const auto& [typeId, componentSize] : mComponentSizes)
+			{
+				if (writeTypeDiff(baseline, target, typeId, componentSize, outDiff))
+				{
+					++typesCount;
+				}
+			}
+			std::memcpy(outDiff.data() + typesCountOffset, &typesCount, sizeof(typesCount));
+		}
+
+		/**
+		 * @brief Applies a diff made by makeDiff to the world
+		 * @param world  Should match the baseline of the diff in entities and the diffed components
+		 * @param outEntityChanges  Optionally receives the entities that were removed and added
+		 * @return false if the diff is malformed or its entities and components don't fit the world, the world is not modified in this case
+		 *
+		 * Removed entities are broadcast as with removeEntity, added entities are broadcast with onEntityAdded
+		 * after the whole diff is applied, so they already have their components.
+		 * Component events are recorded and the changed components are marked as changed.
+		 */
+		bool applyDiff(EntityManager& world, std::span<const std::byte> diff, EntityChanges* outEntityChanges = nullptr) const
+		{
+			ParsedDiff parsedDiff;
+			if (!parseDiff(world, diff, parsedDiff))
+			{
+				RACCOON_ECS_ERROR("World diff is malformed or doesn't match the world, it is not applied");
+				return false;
+			}
+
+			EntityChanges entityChanges;
+
+			// components can exist only on alive entities, so the removed entities go before the slots are restored
+			const std::span<const EntitySlots::Slot> worldSlots = world.mEntitySlots.getSlots();
+			for (const SlotChange& slotChange : parsedDiff.slotChanges)
+			{
+				if (slotChange.entityIdx < worldSlots.size() && worldSlots[slotChange.entityIdx].isAlive())
+				{
+					entityChanges.removedEntities.push_back(world.mEntitySlots.makeEntity(slotChange.entityIdx));
+				}
+			}
+			for (size_t entityIdx = parsedDiff.slotsCount; entityIdx < worldSlots.size(); ++entityIdx)
+			{
+				if (worldSlots[entityIdx].isAlive())
+				{
+					entityChanges.removedEntities.push_back(world.mEntitySlots.makeEntity(entityIdx));
+				}
+			}
+			for (const Entity entity : entityChanges.removedEntities)
+			{
+				world.removeEntity(entity);
+			}
+
+			for (const SlotChange& slotChange : parsedDiff.slotChanges)
+			{
+				world.mEntitySlots.restoreSlot(slotChange.entityIdx, slotChange.slot);
+				if (slotChange.slot.isAlive())
+				{
+					entityChanges.addedEntities.push_back(world.mEntitySlots.makeEntity(slotChange.entityIdx));
+				}
+			}
+			world.mEntitySlots.restoreFreeList(parsedDiff.slotsCount, parsedDiff.firstFreeSlot);
+
+			for (const TypeDiff& typeDiff : parsedDiff.typeDiffs)
+			{
+				applyTypeDiff(world, typeDiff);
+			}
+
+			for (const Entity entity : entityChanges.addedEntities)
+			{
+				world.onEntityAdded.broadcast(entity);
+			}
+
+			if (outEntityChanges != nullptr)
+			{
+				*outEntityChanges = std::move(entityChanges);
+			}
+			return true;
+		}
+
+	private:
+		struct SlotChange
+		{
+			Entity::RawId entityIdx;
+			EntitySlots::Slot slot;
+		};
+
+		struct TypeDiff
+		{
+			ComponentTypeId typeId;
+			size_t componentSize = 0;
+			// sections in the same format as they were written, validated by parseDiff
+			std::span<const std::byte> removedComponents;
+			std::span<const std::byte> addedComponents;
+			std::span<const std::byte> changedComponents;
+			std::span<const std::byte> toggledComponents;
+		};
+
+		struct ParsedDiff
+		{
+			size_t slotsCount = 0;
+			Entity::RawId firstFreeSlot = EntitySlots::Slot::NoNextSlot;
+			// sorted by entity index
+			std::vector<SlotChange> slotChanges;
+			std::vector<TypeDiff> typeDiffs;
+		};
+
+		// sequential reader of the diff data, all reads fail after the data ends
+		struct DataReader
+		{
+			std::span<const std::byte> data;
+
+			template<typename T>
+			bool readValue(T& outValue)
+			{
+				if (data.size() < sizeof(T))
+				{
+					return false;
+				}
+				std::memcpy(&outValue, data.data(), sizeof(T));
+				data = data.subspan(sizeof(T));
+				return true;
+			}
+
+			bool readBytes(const size_t bytesCount, std::span<const std::byte>& outBytes)
+			{
+				if (data.size() < bytesCount)
+				{
+					return false;
+				}
+				outBytes = data.first(bytesCount);
+				data = data.subspan(bytesCount);
+				return true;
+			}
+		};
+
+		using ByteRunValue = std::uint16_t;
+
+		constexpr static std::uint32_t DiffMagic = 0x44574552u; // "REWD"
+		constexpr static std::uint32_t FormatVersion = 1;
+		constexpr static size_t MaxComponentSize = 0xFFFF;
+		// unchanged gaps shorter than the header of a byte run are sent as changed to merge the runs
+		constexpr static size_t ByteRunHeaderSize = sizeof(ByteRunValue) * 2;
+
+	private:
+		bool writeTypeDiff(const EntityManager& baseline, const EntityManager& target, ComponentTypeId typeId, const size_t componentSize, std::vector<std::byte>& outDiff) const
+		{
+			const auto& baselineComponents = baseline.mComponents;
+			const auto& targetComponents = target.mComponents;
+			const std::vector<void*>& baselineVector = baselineComponents.getComponentVectorById(typeId);
+			const std::vector<void*>& targetVector = targetComponents.getComponentVectorById(typeId);
+
+			std::vector<Entity::RawId> removedComponents;
+			std::vector<Entity::RawId> toggledComponents;
+			std::vector<std::byte> addedComponents;
+			std::vector<std::byte> changedComponents;
+			std::uint64_t addedCount = 0;
+			std::uint64_t changedCount = 0;
+
+			const size_t endIdx = (std::min)(target.mEntitySlots.size(), (std::max)(getColumnSize(baseline, typeId), getColumnSize(target, typeId)));
+			for (size_t entityIdx = 0; entityIdx < endIdx; ++entityIdx)
+			{
+				const bool isInTarget = targetComponents.hasComponent(typeId, entityIdx);
+				// components of removed entities are removed with them
+				const bool isInBaseline = isKeptEntity(baseline, target, entityIdx) && baselineComponents.hasComponent(typeId, entityIdx);
+				const Entity::RawId rawId = static_cast<Entity::RawId>(entityIdx);
+
+				if (!isInTarget)
+				{
+					if (isInBaseline)
+					{
+						removedComponents.push_back(rawId);
+					}
+					continue;
+				}
+
+				const bool isEnabledInTarget = targetComponents.isComponentEnabled(typeId, entityIdx);
+				if (!isInBaseline)
+				{
+					writeValue(addedComponents, rawId);
+					writeBytes(addedComponents, componentSize > 0 ? targetVector[entityIdx] : nullptr, componentSize);
+					++addedCount;
+					if (!isEnabledInTarget)
+					{
+						toggledComponents.push_back(rawId);
+					}
+					continue;
+				}
+
+				if (componentSize > 0 && writeChangedBytes(static_cast<const std::byte*>(baselineVector[entityIdx]), static_cast<const std::byte*>(targetVector[entityIdx]), rawId, componentSize, changedComponents))
+				{
+					++changedCount;
+				}
+
+				if (baselineComponents.isComponentEnabled(typeId, entityIdx) != isEnabledInTarget)
+				{
+					toggledComponents.push_back(rawId);
+				}
+			}
+
+			if (removedComponents.empty() && addedCount == 0 && changedCount == 0 && toggledComponents.empty())
+			{
+				return false;
+			}
+
+			writeValue(outDiff, typeId);
+			writeValue(outDiff, static_cast<std::uint64_t>(componentSize));
+			writeIndexes(outDiff, removedComponents);
+			writeValue(outDiff, addedCount);
+			writeBytes(outDiff, addedComponents.data(), addedComponents.size());
+			writeValue(outDiff, changedCount);
+			writeBytes(outDiff, changedComponents.data(), changedComponents.size());
+			writeIndexes(outDiff, toggledComponents);
+			return true;
+		}
+
+		/**
+		 * @brief Writes the ranges of bytes that differ between the components
+		 * @return false if the components are the same, nothing is written then
+		 */
+		static bool writeChangedBytes(const std::byte* baselineComponent, const std::byte* targetComponent, const Entity::RawId rawId, const size_t componentSize, std::vector<std::byte>& outData)
+		{
+			if (std::memcmp(baselineComponent, targetComponent, componentSize) == 0)
+			{
+				return false;
+			}
+
+			writeValue(outData, rawId);
+			const size_t runsCountOffset = outData.size();
+			writeValue(outData, ByteRunValue(0));
+
+			ByteRunValue runsCount = 0;
+			size_t offset = 0;
+			while (offset < componentSize)
+			{
+				if (baselineComponent[offset] == targetComponent[offset])
+				{
+					++offset;
+					continue;
+				}
+
+				const size_t runBegin = offset;
+				size_t runEnd = offset + 1;
+				for (size_t idx = runEnd; idx < componentSize && idx - runEnd <= ByteRunHeaderSize; ++idx)
+				{
+					if (baselineComponent[idx] != targetComponent[idx])
+					{
+						runEnd = idx + 1;
+					}
+				}
+
+				writeValue(outData, static_cast<ByteRunValue>(runBegin));
+				writeValue(outData, static_cast<ByteRunValue>(runEnd - runBegin));
+				writeBytes(outData, targetComponent + runBegin, runEnd - runBegin);
+				++runsCount;
+				offset = runEnd;
+			}
+
+			std::memcpy(outData.data() + runsCountOffset, &runsCount, sizeof(runsCount));
+			return true;
+		}
+
+		bool parseDiff(const EntityManager& world, std::span<const std::byte> diff, ParsedDiff& outParsedDiff) const
+		{
+			DataReader reader{ diff };
+
+			std::uint32_t magic = 0;
+			std::uint32_t formatVersion = 0;
+			std::uint8_t typeIdSize = 0;
+			std::uint64_t slotsCount = 0;
+			std::uint64_t changedSlotsCount = 0;
+			if (!reader.readValue(magic) || magic != DiffMagic
+				|| !reader.readValue(formatVersion) || formatVersion != FormatVersion
+				|| !reader.readValue(typeIdSize) || typeIdSize != sizeof(ComponentTypeId)
+				|| !reader.readValue(slotsCount) || slotsCount >= EntitySlots::Slot::NoNextSlot
+				|| !reader.readValue(outParsedDiff.firstFreeSlot)
+				|| !reader.readValue(changedSlotsCount) || changedSlotsCount > reader.data.size() / (sizeof(Entity::RawId) + sizeof(EntitySlots::Slot)))
+			{
+				return false;
+			}
+			outParsedDiff.slotsCount = static_cast<size_t>(slotsCount);
+			if (outParsedDiff.firstFreeSlot != EntitySlots::Slot::NoNextSlot && outParsedDiff.firstFreeSlot >= slotsCount)
+			{
+				return false;
+			}
+
+			outParsedDiff.slotChanges.resize(static_cast<size_t>(changedSlotsCount));
+			for (size_t i = 0; i < outParsedDiff.slotChanges.size(); ++i)
+			{
+				SlotChange& slotChange = outParsedDiff.slotChanges[i];
+				if (!reader.readValue(slotChange.entityIdx) || !reader.readValue(slotChange.slot)
+					|| slotChange.entityIdx >= slotsCount
+					|| (i > 0 && slotChange.entityIdx <= outParsedDiff.slotChanges[i - 1].entityIdx))
+				{
+					return false;
+				}
+			}
+			// the slots added by the diff should all be listed in it
+			const size_t worldSlotsCount = world.mEntitySlots.size();
+			if (slotsCount > worldSlotsCount && static_cast<size_t>(outParsedDiff.slotChanges.end() - findFirstSlotChange(outParsedDiff, worldSlotsCount)) != slotsCount - worldSlotsCount)
+			{
+				return false;
+			}
+			// the free list goes through both the changed slots and the ones the diff leaves as they are
+			{
+				const std::span<const EntitySlots::Slot> worldSlots = world.mEntitySlots.getSlots();
+				std::vector<EntitySlots::Slot> resultSlots(worldSlots.begin(), worldSlots.end());
+				resultSlots.resize(outParsedDiff.slotsCount);
+				for (const SlotChange& slotChange : outParsedDiff.slotChanges)
+				{
+					resultSlots[slotChange.entityIdx] = slotChange.slot;
+				}
+				if (!EntitySlots::IsFreeListValid(resultSlots, outParsedDiff.firstFreeSlot))
+				{
+					return false;
+				}
+			}
+
+			std::uint64_t typesCount = 0;
+			if (!reader.readValue(typesCount) || typesCount > reader.data.size())
+			{
+				return false;
+			}
+
+			outParsedDiff.typeDiffs.resize(static_cast<size_t>(typesCount));
+			for (size_t i = 0; i < outParsedDiff.typeDiffs.size(); ++i)
+			{
+				TypeDiff& typeDiff = outParsedDiff.typeDiffs[i];
+				if (!parseTypeDiff(world, outParsedDiff, reader, typeDiff))
+				{
+					return false;
+				}
+
+				// sections are validated against the world before the diff, so a repeated one could add the same components twice
+				const auto parsedEnd = outParsedDiff.typeDiffs.begin() + static_cast<std::ptrdiff_t>(i);
+				if (std::any_of(outParsedDiff.typeDiffs.begin(), parsedEnd, [&typeDiff](const TypeDiff& parsedTypeDiff) { return parsedTypeDiff.typeId == typeDiff.typeId; }))
+				{
+					RACCOON_ECS_ERROR(std::string("Component type is stored in the world diff more than once: ") + toString(typeDiff.typeId));
+					return false;
+				}
+			}
+
+			return reader.data.empty();
+		}
+
+		bool parseTypeDiff(const EntityManager& world, const ParsedDiff& parsedDiff, DataReader& reader, TypeDiff& outTypeDiff) const
+		{
+			std::uint64_t componentSize = 0;
+			if (!reader.readValue(outTypeDiff.typeId) || !reader.readValue(componentSize))
+			{
+				return false;
+			}
+
+			const auto it = mComponentSizes.find(outTypeDiff.typeId);
+			if (it == mComponentSizes.end() || it->second != componentSize || world.mComponentFactory.get().isTagComponent(outTypeDiff.typeId) != (componentSize == 0))
+			{
+				RACCOON_ECS_ERROR(std::string("World diff contains a component type that is not registered or has a different size: ") + toString(outTypeDiff.typeId));
+				return false;
+			}
+			outTypeDiff.componentSize = static_cast<size_t>(componentSize);
+
+			const auto& worldComponents = world.mComponents;
+			const ComponentTypeId typeId = outTypeDiff.typeId;
+			auto hasKeptComponent = [&world, &parsedDiff, &worldComponents, typeId](const size_t entityIdx) {
+				return isKeptEntityAfterDiff(world, parsedDiff, entityIdx) && worldComponents.hasComponent(typeId, entityIdx);
+			};
+
+			std::vector<Entity::RawId> removedComponents;
+			std::vector<Entity::RawId> addedComponents;
+			auto hasRemainingComponent = [&hasKeptComponent, &removedComponents](const Entity::RawId entityIdx) {
+				return hasKeptComponent(entityIdx) && !std::binary_search(removedComponents.begin(), removedComponents.end(), entityIdx);
+			};
+
+			return parseIndexes(reader, outTypeDiff.removedComponents, [&hasKeptComponent, &removedComponents](const Entity::RawId entityIdx) {
+					removedComponents.push_back(entityIdx);
+					return hasKeptComponent(entityIdx);
+				})
+				&& parseEntries(reader, outTypeDiff.addedComponents, [&](DataReader& entryReader) {
+					Entity::RawId entityIdx;
+					std::span<const std::byte> componentBytes;
+					if (!entryReader.readValue(entityIdx) || !entryReader.readBytes(outTypeDiff.componentSize, componentBytes)
+						|| (!addedComponents.empty() && entityIdx <= addedComponents.back())
+						|| !isAliveAfterDiff(world, parsedDiff, entityIdx) || hasKeptComponent(entityIdx))
+					{
+						return false;
+					}
+					addedComponents.push_back(entityIdx);
+					return true;
+				})
+				&& parseEntries(reader, outTypeDiff.changedComponents, [&, previousIdx = Entity::RawId(0), isFirst = true](DataReader& entryReader) mutable {
+					Entity::RawId entityIdx;
+					ByteRunValue runsCount = 0;
+					if (!entryReader.readValue(entityIdx) || !entryReader.readValue(runsCount)
+						|| (!isFirst && entityIdx <= previousIdx) || outTypeDiff.componentSize == 0 || !hasRemainingComponent(entityIdx))
+					{
+						return false;
+					}
+					isFirst = false;
+					previousIdx = entityIdx;
+
+					for (ByteRunValue i = 0; i < runsCount; ++i)
+					{
+						ByteRunValue runOffset = 0;
+						ByteRunValue runSize = 0;
+						std::span<const std::byte> runBytes;
+						if (!entryReader.readValue(runOffset) || !entryReader.readValue(runSize)
+							|| static_cast<size_t>(runOffset) + runSize > outTypeDiff.componentSize
+							|| !entryReader.readBytes(runSize, runBytes))
+						{
+							return false;
+						}
+					}
+					return true;
+				})
+				&& parseIndexes(reader, outTypeDiff.toggledComponents, [&](const Entity::RawId entityIdx) {
+					return hasRemainingComponent(entityIdx) || std::binary_search(addedComponents.begin(), addedComponents.end(), entityIdx);
+				});
+		}
+
+		/**
+		 * @brief Reads a sorted list of entity indexes
+		 */
+		template<typename ValidateFn>
+		static bool parseIndexes(DataReader& reader, std::span<const std::byte>& outSection, ValidateFn&& validateFn)
+		{
+			return parseEntries(reader, outSection, [&validateFn, previousIdx = Entity::RawId(0), isFirst = true](DataReader& entryReader) mutable {
+				Entity::RawId entityIdx;
+				if (!entryReader.readValue(entityIdx) || (!isFirst && entityIdx <= previousIdx) || !validateFn(entityIdx))
+				{
+					return false;
+				}
+				isFirst = false;
+				previousIdx = entityIdx;
+				return true;
+			});
+		}
+
+		/**
+		 * @brief Reads a section that starts with the amount of entries and remembers its entries
+		 */
+		template<typename ParseEntryFn>
+		static bool parseEntries(DataReader& reader, std::span<const std::byte>& outSection, ParseEntryFn&& parseEntryFn)
+		{
+			std::uint64_t entriesCount = 0;
+			if (!reader.readValue(entriesCount) || entriesCount > reader.data.size())
+			{
+				return false;
+			}
+
+			const std::span<const std::byte> sectionBegin = reader.data;
+			for (std::uint64_t i = 0; i < entriesCount; ++i)
+			{
+				if (!parseEntryFn(reader))
+				{
+					return false;
+				}
+			}
+			outSection = sectionBegin.first(sectionBegin.size() - reader.data.size());
+			return true;
+		}
+
+		static void applyTypeDiff(EntityManager& world, const TypeDiff& typeDiff)
+		{
+			const ComponentTypeId typeId = typeDiff.typeId;
+			DataReader reader;
+
+			reader.data = typeDiff.removedComponents;
+			Entity::RawId entityIdx;
+			while (reader.readValue(entityIdx))
+			{
+				world.removeComponent(world.mEntitySlots.makeEntity(entityIdx), typeId);
+			}
+
+			reader.data = typeDiff.addedComponents;
+			while (reader.readValue(entityIdx))
+			{
+				void* component = world.addComponentByType(world.mEntitySlots.makeEntity(entityIdx), typeId);
+				std::span<const std::byte> componentBytes;
+				reader.readBytes(typeDiff.componentSize, componentBytes);
+				if (!componentBytes.empty())
+				{
+					std::memcpy(component, componentBytes.data(), componentBytes.size());
+				}
+			}
+
+			reader.data = typeDiff.changedComponents;
+			std::vector<void*>& componentVector = world.mComponents.getComponentVectorById(typeId);
+			while (reader.readValue(entityIdx))
+			{
+				void*& component = componentVector[entityIdx];
+#ifdef RACCOON_ECS_COPY_ON_WRITE_COMPONENTS
+				world.makeComponentUnique(typeId, entityIdx, component);
+#endif // RACCOON_ECS_COPY_ON_WRITE_COMPONENTS
+
+				ByteRunValue runsCount = 0;
+				reader.readValue(runsCount);
+				for (ByteRunValue i = 0; i < runsCount; ++i)
+				{
+					ByteRunValue runOffset = 0;
+					std::span<const std::byte> runBytes;
+					ByteRunValue runSize = 0;
+					reader.readValue(runOffset);
+					reader.readValue(runSize);
+					reader.readBytes(runSize, runBytes);
+					std::memcpy(static_cast<std::byte*>(component) + runOffset, runBytes.data(), runBytes.size());
+				}
+				world.mComponentChangeTicks.markChanged(typeId, entityIdx);
+			}
+
+			reader.data = typeDiff.toggledComponents;
+			while (reader.readValue(entityIdx))
+			{
+				world.setComponentEnabled(world.mEntitySlots.makeEntity(entityIdx), typeId, !world.mComponents.isComponentEnabled(typeId, entityIdx));
+			}
+		}
+
+		/**
+		 * @return true if the entity is alive with the same version in both managers
+		 */
+		static bool isKeptEntity(const EntityManager& baseline, const EntityManager& target, const size_t entityIdx)
+		{
+			return entityIdx < baseline.mEntitySlots.size()
+				&& entityIdx < target.mEntitySlots.size()
+				&& baseline.mEntitySlots.isAlive(entityIdx)
+				&& isSameSlot(baseline.mEntitySlots.getSlot(entityIdx), target.mEntitySlots.getSlot(entityIdx));
+		}
+
+		static bool isKeptEntityAfterDiff(const EntityManager& world, const ParsedDiff& parsedDiff, const size_t entityIdx)
+		{
+			return entityIdx < parsedDiff.slotsCount && world.mEntitySlots.isAlive(entityIdx) && findSlotChange(parsedDiff, entityIdx) == nullptr;
+		}
+
+		static bool isAliveAfterDiff(const EntityManager& world, const ParsedDiff& parsedDiff, const size_t entityIdx)
+		{
+			if (const SlotChange* slotChange = findSlotChange(parsedDiff, entityIdx))
+			{
+				return slotChange->slot.isAlive();
+			}
+			return isKeptEntityAfterDiff(world, parsedDiff, entityIdx);
+		}
+
+		static auto findFirstSlotChange(const ParsedDiff& parsedDiff, const size_t minEntityIdx)
+		{
+			return std::lower_bound(parsedDiff.slotChanges.begin(), parsedDiff.slotChanges.end(), minEntityIdx, [](const SlotChange& slotChange, const size_t idx) {
+				return slotChange.entityIdx < idx;
+			});
+		}
+
+		static const SlotChange* findSlotChange(const ParsedDiff& parsedDiff, const size_t entityIdx)
+		{
+			const auto it = findFirstSlotChange(parsedDiff, entityIdx);
+			return (it != parsedDiff.slotChanges.end() && it->entityIdx == entityIdx) ? &*it : nullptr;
+		}
+
+		static size_t getColumnSize(const EntityManager& world, ComponentTypeId typeId)
+		{
+			if (const auto* tagStorage = world.mComponents.getTagStorageById(typeId))
+			{
+				return tagStorage->flags.size();
+			}
+			return world.mComponents.getComponentVectorById(typeId).size();
+		}
+
+		static bool isSameSlot(const EntitySlots::Slot& first, const EntitySlots::Slot& second) noexcept
+		{
+			return first.version == second.version && first.nextFreeSlot == second.nextFreeSlot;
+		}
+
+		static void writeIndexes(std::vector<std::byte>& outData, const std::vector<Entity::RawId>& indexes)
+		{
+			writeValue(outData, static_cast<std::uint64_t>(indexes.size()));
+			writeBytes(outData, indexes.data(), indexes.size() * sizeof(Entity::RawId));
+		}
+
+		template<typename T>
+		static void writeValue(std::vector<std::byte>& outData, const T& value)
+		{
+			writeBytes(outData, &value, sizeof(T));
+		}
+
+		static void writeBytes(std::vector<std::byte>& outData, const void* bytes, const size_t bytesCount)
+		{
+			const size_t offset = outData.size();
+			outData.resize(offset + bytesCount);
+			if (bytesCount > 0)
+			{
+				std::memcpy(outData.data() + offset, bytes, bytesCount);
+			}
+		}
+
+	private:
+		std::unordered_map<ComponentTypeId, size_t> mComponentSizes;
+	};
+} // namespace RaccoonEcs